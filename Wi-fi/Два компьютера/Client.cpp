@@ -48,15 +48,18 @@ int main()
         if(strcmp(user_input, "Stop connect") == 0)
             break;
 
-        // Отправляем сообщение серверу
-        send(sock, user_input, strlen(user_input), 0);
+        // Отправляем сообщение серверу; команды разделяются '\n' -
+        // сервер исполняет только законченные строки
+        size_t msg_len = strlen(user_input);
+        user_input[msg_len++] = '\n';
+        send(sock, user_input, msg_len, 0);
 
         // Получаем ответ от сервера
         int bytes_read = recv(sock, buf, BUFFER_SIZE-1, 0);
         if(bytes_read > 0)
         {
             buf[bytes_read] = '\0';
-            printf("Получено от сервера: %s\n", buf);
+            printf("Получено от сервера: %s", buf);
         }
         else
         {
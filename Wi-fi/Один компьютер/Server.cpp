@@ -1,27 +1,406 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
 #include <unistd.h>
 
+#define PORT 8025
+#define BUFFER_SIZE 1024
+#define MAX_CLIENTS 8
+#define COMMAND_SIZE 64
+
+// Очередь команд робота
+#define QUEUE_CAPACITY 64
+#define HIGH_WATERMARK 32       // с этой глубины новые команды отклоняются (BUSY)
+#define LOW_WATERMARK 16        // до этой глубины очередь должна разгрузиться
+#define MAX_COMMAND_AGE_MS 500  // команда, ждавшая дольше, устарела и не исполняется
+// Имитация исполнительного механизма: время исполнения одной команды
+#define ACTUATOR_STEP_MS 100
+#define METRICS_PERIOD_MS 1000
+
+// stop - команда безопасности: обгоняет очередь и прерывает движение;
+// одинаковые до байта команды движения подряд (автоповтор клавиши)
+// сливаются в одну, отправителю заменённой - CANCELLED
+enum command_kind { CMD_STOP, CMD_MOTION, CMD_OTHER, CMD_STATS };
+
+struct command
+{
+    enum command_kind kind;
+    char text[COMMAND_SIZE];
+    long long enqueued_ms;
+    unsigned client_id;         // кому сообщить, если команда не исполнится
+};
+
+// Подключение пульта: команды идут строками через '\n', строка может
+// прийти по частям или вместе с соседними - копим до конца строки
+struct client
+{
+    unsigned id;
+    char pending[BUFFER_SIZE];
+    size_t pending_len;
+};
+
+struct robot_queue
+{
+    struct command items[QUEUE_CAPACITY];
+    int head;
+    int count;
+    int stop_pending;
+    long long stop_ms;
+    int busy;                   // включено противодавление
+    int executing;
+    struct command current;
+    long long actuator_free_ms; // когда механизм освободится
+
+    // Метрики: счётчики с запуска
+    unsigned long accepted;
+    unsigned long coalesced;
+    unsigned long rejected;
+    unsigned long expired;
+    unsigned long dispatched;
+    // и за последний период METRICS_PERIOD_MS
+    int max_depth;
+    long long latency_sum;
+    long long latency_max;
+    unsigned long latency_count;
+};
+
+// fds[0] - слушающий сокет, fds[i] и clients[i] - одно подключение
+static struct pollfd fds[MAX_CLIENTS + 1];
+static struct client clients[MAX_CLIENTS + 1];
+static int nfds = 1;
+
+static long long now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Длина первого слова команды ("forward 2000" -> 7)
+static size_t verb_length(const char *text)
+{
+    return strcspn(text, " \t");
+}
+
+static int same_verb(const char *a, const char *b)
+{
+    size_t len = verb_length(a);
+    return len == verb_length(b) && strncasecmp(a, b, len) == 0;
+}
+
+static enum command_kind classify(const char *text)
+{
+    static const char *motions[] = { "forward", "backward", "left", "right" };
+    if(same_verb(text, "stop"))
+        return CMD_STOP;
+    if(same_verb(text, "stats"))
+        return CMD_STATS;
+    for(size_t i = 0; i < sizeof(motions) / sizeof(motions[0]); i++)
+    {
+        if(same_verb(text, motions[i]))
+            return CMD_MOTION;
+    }
+    return CMD_OTHER;
+}
+
+// Ответ клиенту: каждая строка заканчивается '\n'. Клиент мог уже
+// отключиться - тогда сообщение некому отправлять
+static void notify_client(unsigned client_id, const char *message)
+{
+    for(int i = 1; i < nfds; i++)
+    {
+        if(clients[i].id == client_id)
+        {
+            send(fds[i].fd, message, strlen(message), MSG_NOSIGNAL);
+            return;
+        }
+    }
+}
+
+static struct command *queue_at(struct robot_queue *q, int i)
+{
+    return &q->items[(q->head + i) % QUEUE_CAPACITY];
+}
+
+static long long oldest_age(struct robot_queue *q, long long now)
+{
+    if(q->stop_pending)
+        return now - q->stop_ms;
+    return q->count > 0 ? now - queue_at(q, 0)->enqueued_ms : 0;
+}
+
+// Гистерезис: BUSY с HIGH_WATERMARK до разгрузки до LOW_WATERMARK
+static void update_backpressure(struct robot_queue *q)
+{
+    if(q->count >= HIGH_WATERMARK)
+        q->busy = 1;
+    else if(q->count <= LOW_WATERMARK)
+        q->busy = 0;
+}
+
+// Убирает из очереди ожидающие команды движения (их отменил stop)
+static void drop_motion(struct robot_queue *q)
+{
+    int kept = 0;
+    for(int i = 0; i < q->count; i++)
+    {
+        struct command *cmd = queue_at(q, i);
+        if(cmd->kind != CMD_MOTION)
+        {
+            *queue_at(q, kept++) = *cmd;
+            continue;
+        }
+        char message[COMMAND_SIZE + 32];
+        snprintf(message, sizeof(message), "CANCELLED %s\n", cmd->text);
+        notify_client(cmd->client_id, message);
+    }
+    q->count = kept;
+}
+
+static void format_stats(struct robot_queue *q, long long now, char *out, size_t size)
+{
+    snprintf(out, size,
+             "depth=%d max_depth=%d oldest_ms=%lld busy=%d accepted=%lu coalesced=%lu "
+             "rejected=%lu expired=%lu dispatched=%lu latency_avg_ms=%lld latency_max_ms=%lld",
+             q->count + q->stop_pending, q->max_depth, oldest_age(q, now), q->busy,
+             q->accepted, q->coalesced, q->rejected, q->expired, q->dispatched,
+             q->latency_count ? q->latency_sum / (long long)q->latency_count : 0,
+             q->latency_max);
+}
+
+// Ставит команду в очередь; в reply - ответ клиенту
+static void enqueue(struct robot_queue *q, const char *text, unsigned client_id, long long now,
+                    char *reply, size_t size)
+{
+    enum command_kind kind = classify(text);
+
+    if(kind == CMD_STATS)
+    {
+        format_stats(q, now, reply, size);
+        return;
+    }
+
+    if(kind == CMD_STOP)
+    {
+        // Повторный stop не сдвигает время первого
+        if(!q->stop_pending)
+            q->stop_ms = now;
+        q->stop_pending = 1;
+        drop_motion(q);
+        // Прерываем исполняемое движение
+        if(q->executing && q->current.kind == CMD_MOTION)
+            q->actuator_free_ms = now;
+        q->accepted++;
+        update_backpressure(q);
+        snprintf(reply, size, "OK stop");
+        return;
+    }
+
+    // Та же команда движения в хвосте ещё не исполнена - заменяем её новой.
+    // Только точный повтор: "forward 1000" после "forward 2000" - другой шаг
+    if(kind == CMD_MOTION && q->count > 0)
+    {
+        struct command *tail = queue_at(q, q->count - 1);
+        if(tail->kind == CMD_MOTION && strcmp(tail->text, text) == 0)
+        {
+            char message[COMMAND_SIZE + 32];
+            snprintf(message, sizeof(message), "CANCELLED %s\n", tail->text);
+            notify_client(tail->client_id, message);
+            tail->enqueued_ms = now;
+            tail->client_id = client_id;
+            q->coalesced++;
+            snprintf(reply, size, "OK coalesced depth=%d", q->count);
+            return;
+        }
+    }
+
+    update_backpressure(q);
+    if(q->busy || q->count == QUEUE_CAPACITY)
+    {
+        q->rejected++;
+        snprintf(reply, size, "BUSY depth=%d retry_ms=%d", q->count, ACTUATOR_STEP_MS);
+        return;
+    }
+
+    struct command *cmd = queue_at(q, q->count++);
+    cmd->kind = kind;
+    snprintf(cmd->text, sizeof(cmd->text), "%s", text);
+    cmd->enqueued_ms = now;
+    cmd->client_id = client_id;
+    q->accepted++;
+    if(q->count > q->max_depth)
+        q->max_depth = q->count;
+    update_backpressure(q);
+    snprintf(reply, size, "OK queued depth=%d", q->count);
+}
+
+static void execute(struct robot_queue *q, const struct command *cmd, long long now)
+{
+    long long latency = now - cmd->enqueued_ms;
+    q->current = *cmd;
+    q->executing = 1;
+    q->actuator_free_ms = now + (cmd->kind == CMD_STOP ? 0 : ACTUATOR_STEP_MS);
+    q->dispatched++;
+    q->latency_sum += latency;
+    q->latency_count++;
+    if(latency > q->latency_max)
+        q->latency_max = latency;
+    printf("-> робот: %s (ожидание %lld мс)\n", cmd->text, latency);
+}
+
+// Передаёт механизму следующую команду, если он свободен
+static void dispatch(struct robot_queue *q, long long now)
+{
+    if(q->executing && now < q->actuator_free_ms)
+        return;
+    q->executing = 0;
+
+    if(q->stop_pending)
+    {
+        struct command stop;
+        stop.kind = CMD_STOP;
+        snprintf(stop.text, sizeof(stop.text), "stop");
+        stop.enqueued_ms = q->stop_ms;
+        q->stop_pending = 0;
+        execute(q, &stop, now);
+        return;
+    }
+
+    while(q->count > 0)
+    {
+        struct command cmd = *queue_at(q, 0);
+        q->head = (q->head + 1) % QUEUE_CAPACITY;
+        q->count--;
+        update_backpressure(q);
+        // Устаревшая команда не исполняется: задержка до механизма
+        // ограничена MAX_COMMAND_AGE_MS + ACTUATOR_STEP_MS
+        if(now - cmd.enqueued_ms > MAX_COMMAND_AGE_MS)
+        {
+            q->expired++;
+            printf("устарела: %s (%lld мс)\n", cmd.text, now - cmd.enqueued_ms);
+            // Клиенту уже ответили "OK queued" - сообщаем, что команда снята
+            char message[COMMAND_SIZE + 48];
+            snprintf(message, sizeof(message), "EXPIRED %s age_ms=%lld\n", cmd.text, now - cmd.enqueued_ms);
+            notify_client(cmd.client_id, message);
+            continue;
+        }
+        execute(q, &cmd, now);
+        return;
+    }
+}
+
+// Время до следующего события очереди для poll()
+static int next_timeout(struct robot_queue *q, long long now, long long next_metrics)
+{
+    long long deadline = next_metrics;
+    if(q->executing)
+    {
+        if(q->actuator_free_ms < deadline)
+            deadline = q->actuator_free_ms;
+    }
+    else if(q->count > 0 || q->stop_pending)
+    {
+        deadline = now;
+    }
+    return deadline > now ? (int)(deadline - now) : 0;
+}
+
+// Разбирает полученные байты: исполняются только законченные строки,
+// хвост ждёт следующего recv(). Ответы - по строке на каждую команду
+static void handle_input(struct robot_queue *q, int index, const char *data, size_t size)
+{
+    struct client *c = &clients[index];
+    char reply[BUFFER_SIZE];
+    size_t used = 0;
+
+    for(size_t pos = 0; pos < size; pos++)
+    {
+        if(data[pos] != '\n')
+        {
+            if(c->pending_len < sizeof(c->pending) - 1)
+                c->pending[c->pending_len] = data[pos];
+            // Слишком длинная строка не режется на куски-команды:
+            // считаем длину дальше и отклоняем её целиком
+            c->pending_len++;
+            continue;
+        }
+
+        char answer[256];
+        if(c->pending_len >= sizeof(c->pending))
+        {
+            snprintf(answer, sizeof(answer), "ERROR line too long max=%d", COMMAND_SIZE - 1);
+        }
+        else
+        {
+            c->pending[c->pending_len] = '\0';
+            char *line = c->pending;
+            while(*line == ' ')
+                line++;
+            size_t len = strlen(line);
+            while(len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' '))
+                line[--len] = '\0';
+            if(*line == '\0')
+            {
+                snprintf(answer, sizeof(answer), "EMPTY");
+            }
+            else if(len >= COMMAND_SIZE)
+            {
+                // Не влезает в очередь целиком - не режем, отклоняем
+                snprintf(answer, sizeof(answer), "ERROR line too long max=%d", COMMAND_SIZE - 1);
+            }
+            else
+            {
+                // stop и слияние движения снимают команды, о которых клиенту
+                // ещё не ответили: сначала отправляем "OK queued", потом "CANCELLED"
+                enum command_kind kind = classify(line);
+                if((kind == CMD_STOP || kind == CMD_MOTION) && used > 0)
+                {
+                    send(fds[index].fd, reply, used, MSG_NOSIGNAL);
+                    used = 0;
+                }
+                enqueue(q, line, c->id, now_ms(), answer, sizeof(answer));
+            }
+        }
+        c->pending_len = 0;
+
+        // Ответы одного recv() уходят одним send(); если не влезли - досылаем
+        size_t need = strlen(answer) + 1;
+        if(used + need > sizeof(reply))
+        {
+            send(fds[index].fd, reply, used, MSG_NOSIGNAL);
+            used = 0;
+        }
+        used += snprintf(reply + used, sizeof(reply) - used, "%s\n", answer);
+    }
+    if(used > 0)
+        send(fds[index].fd, reply, used, MSG_NOSIGNAL);
+}
+
 int main()
 {
-    printf("%s\n", "-1");
-    int sock, listener;
+    int listener;
     struct sockaddr_in addr;
-    char buf[1024];
-    int bytes_read;
-    printf("%s\n", "0");
+    char buf[BUFFER_SIZE];
+    unsigned next_client_id = 1;
+    static struct robot_queue queue;
+
     listener = socket(AF_INET, SOCK_STREAM, 0);
     if(listener < 0)
     {
         perror("socket");
         exit(1);
     }
-    printf("%s\n", "1");
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(8025);
+    addr.sin_port = htons(PORT);
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
     if(bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0)
     {
@@ -29,28 +408,80 @@ int main()
         exit(2);
     }
 
-    listen(listener, 1);
-    printf("%s\n", "2");
+    listen(listener, MAX_CLIENTS);
+    printf("Сервер слушает порт %d\n", PORT);
+
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+    long long next_metrics = now_ms() + METRICS_PERIOD_MS;
+
     while(1)
     {
-        sock = accept(listener, NULL, NULL);
-        if(sock < 0)
+        int timeout = next_timeout(&queue, now_ms(), next_metrics);
+        if(poll(fds, nfds, timeout) < 0)
         {
-            perror("accept");
+            perror("poll");
             exit(3);
         }
-        
-        while(1)
+
+        if(fds[0].revents & POLLIN)
+        {
+            int sock = accept(listener, NULL, NULL);
+            if(sock < 0)
+            {
+                perror("accept");
+            }
+            else if(nfds == MAX_CLIENTS + 1)
+            {
+                send(sock, "BUSY clients\n", 13, MSG_NOSIGNAL);
+                close(sock);
+            }
+            else
+            {
+                fds[nfds].fd = sock;
+                fds[nfds].events = POLLIN;
+                fds[nfds].revents = 0;
+                clients[nfds].id = next_client_id++;
+                clients[nfds].pending_len = 0;
+                nfds++;
+                printf("Клиент подключен (%d)\n", nfds - 1);
+            }
+        }
+
+        for(int i = 1; i < nfds; i++)
         {
-            bytes_read = recv(sock, buf, 1024, 0);
-            if(bytes_read <= 0) break;
-            send(sock, buf, bytes_read, 0);
-            printf("%s\n", "3");
+            if(!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            int bytes_read = recv(fds[i].fd, buf, BUFFER_SIZE, 0);
+            if(bytes_read <= 0)
+            {
+                close(fds[i].fd);
+                nfds--;
+                fds[i] = fds[nfds];
+                clients[i] = clients[nfds];
+                i--;
+                printf("Клиент отключен (%d)\n", nfds - 1);
+                continue;
+            }
+            handle_input(&queue, i, buf, bytes_read);
+        }
+
+        long long now = now_ms();
+        dispatch(&queue, now);
+
+        if(now >= next_metrics)
+        {
+            char stats[512];
+            format_stats(&queue, now, stats, sizeof(stats));
+            printf("[очередь] %s\n", stats);
+            fflush(stdout);
+            queue.max_depth = queue.count;
+            queue.latency_sum = 0;
+            queue.latency_max = 0;
+            queue.latency_count = 0;
+            next_metrics = now + METRICS_PERIOD_MS;
         }
-    
-        close(sock);
     }
-    printf("%s\n", "3");
-    
+
     return 0;
 }
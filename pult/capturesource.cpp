@@ -0,0 +1,287 @@
+#include "capturesource.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+
+namespace {
+
+// Сглаживание FPS и задержки чтения
+const double kStatsSmoothing = 0.1;
+// После стольких неудачных чтений подряд камера считается потерянной
+const int kMaxReadFailures = 50;
+
+// Камера через cv::VideoCapture
+class CameraDevice : public FrameDevice
+{
+public:
+    explicit CameraDevice(int deviceIndex)
+        : deviceIndex(deviceIndex)
+    {
+    }
+
+    bool open() override
+    {
+        return capture.open(deviceIndex) && capture.isOpened();
+    }
+
+    bool grab() override
+    {
+        return capture.grab();
+    }
+
+    bool retrieve(cv::Mat &frame) override
+    {
+        return capture.retrieve(frame);
+    }
+
+    void close() override
+    {
+        capture.release();
+    }
+
+private:
+    int deviceIndex;
+    cv::VideoCapture capture;
+};
+
+} // namespace
+
+// Состояние, общее для владельца и потока захвата. Поток держит свою
+// ссылку, поэтому зависшее устройство можно бросить, не блокируя GUI.
+struct CaptureSource::Shared
+{
+    QString name;
+    int deviceIndex;
+    std::unique_ptr<FrameDevice> device;
+    int probeTimeoutMs;
+    QElapsedTimer probeClock;
+    WorkPool *pool = nullptr;
+    ResourceAccount *account = nullptr;
+
+    std::atomic<bool> stopRequested{false};
+    std::atomic<int> state{static_cast<int>(State::Probing)};
+    std::atomic<qint64> openTimeMs{-1};
+
+    std::size_t ringBytes = 0;
+
+    mutable std::mutex mutex;
+    // Выделяется по первому кадру: ringBytes / размер кадра слотов
+    std::vector<cv::Mat> slots;
+    std::vector<qint64> timestamps;
+    size_t head = 0;
+    size_t count = 0;
+    double fps = 0.0;
+    double readLatencyMs = 0.0;
+};
+
+CaptureSource::CaptureSource(const QString &name, int deviceIndex, std::size_t ringBytes)
+    : CaptureSource(name, std::make_unique<CameraDevice>(deviceIndex), ringBytes)
+{
+    d->deviceIndex = deviceIndex;
+}
+
+CaptureSource::CaptureSource(const QString &name, std::unique_ptr<FrameDevice> device, std::size_t ringBytes)
+    : d(std::make_shared<Shared>())
+{
+    d->name = name;
+    d->deviceIndex = -1;
+    d->device = std::move(device);
+    d->probeTimeoutMs = 0;
+    d->ringBytes = ringBytes;
+}
+
+CaptureSource::~CaptureSource()
+{
+    stop();
+}
+
+void CaptureSource::start(int probeTimeoutMs, WorkPool &pool, ResourceAccount &account)
+{
+    if (worker.joinable()) {
+        return;
+    }
+    d->pool = &pool;
+    d->account = &account;
+    d->probeTimeoutMs = probeTimeoutMs;
+    d->probeClock.start();
+    worker = std::thread(&CaptureSource::run, d);
+}
+
+void CaptureSource::stop()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    d->stopRequested = true;
+    // Поток, зависший в открытии устройства, не дожидаемся
+    if (static_cast<State>(d->state.load()) == State::Probing) {
+        worker.detach();
+    } else {
+        worker.join();
+    }
+}
+
+QString CaptureSource::name() const
+{
+    return d->name;
+}
+
+int CaptureSource::deviceIndex() const
+{
+    return d->deviceIndex;
+}
+
+CaptureSource::State CaptureSource::state() const
+{
+    const State current = static_cast<State>(d->state.load());
+    if (current == State::Probing && d->probeClock.isValid()
+        && d->probeClock.elapsed() > d->probeTimeoutMs) {
+        return State::Unavailable;
+    }
+    return current;
+}
+
+qint64 CaptureSource::openTimeMs() const
+{
+    return d->openTimeMs.load();
+}
+
+bool CaptureSource::openedLate() const
+{
+    return d->openTimeMs.load() > d->probeTimeoutMs;
+}
+
+bool CaptureSource::latestFrame(cv::Mat &out, qint64 *timestampMs) const
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if (d->count == 0) {
+        return false;
+    }
+    const size_t capacity = d->slots.size();
+    const size_t last = (d->head + capacity - 1) % capacity;
+    d->slots[last].copyTo(out);
+    if (timestampMs) {
+        *timestampMs = d->timestamps[last];
+    }
+    return true;
+}
+
+void CaptureSource::takeRecording(std::vector<cv::Mat> &frames, std::vector<qint64> &timestamps)
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    const size_t capacity = d->slots.size();
+    frames.reserve(frames.size() + d->count);
+    timestamps.reserve(timestamps.size() + d->count);
+    for (size_t i = 0; i < d->count; ++i) {
+        const size_t index = (d->head + capacity - d->count + i) % capacity;
+        // Последний кадр остаётся в буфере для отображения
+        if (i + 1 == d->count) {
+            frames.push_back(d->slots[index].clone());
+        } else {
+            frames.push_back(std::move(d->slots[index]));
+            d->slots[index] = cv::Mat();
+        }
+        timestamps.push_back(d->timestamps[index]);
+    }
+    if (d->count > 0) {
+        d->count = 1;
+    }
+}
+
+qint64 CaptureSource::lastFrameTimeMs() const
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if (d->count == 0) {
+        return -1;
+    }
+    const size_t capacity = d->slots.size();
+    return d->timestamps[(d->head + capacity - 1) % capacity];
+}
+
+double CaptureSource::fps() const
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->fps;
+}
+
+double CaptureSource::readLatencyMs() const
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->readLatencyMs;
+}
+
+void CaptureSource::run(std::shared_ptr<Shared> shared)
+{
+    FrameDevice &device = *shared->device;
+    if (!device.open() || shared->stopRequested) {
+        shared->state = static_cast<int>(State::Unavailable);
+        return;
+    }
+    shared->openTimeMs = shared->probeClock.elapsed();
+    shared->state = static_cast<int>(State::Running);
+
+    cv::Mat grabbed;
+    QElapsedTimer readClock;
+    qint64 previousFrameNs = -1;
+    int failures = 0;
+
+    while (!shared->stopRequested) {
+        readClock.start();
+        const bool grabOk = device.grab();
+        const qint64 readNs = readClock.nsecsElapsed();
+
+        // Декодирование - задача пула за счёт сессии; поток захвата
+        // дожидается её, прежде чем снова трогать устройство
+        bool retrieveOk = false;
+        if (grabOk) {
+            std::promise<bool> done;
+            std::future<bool> result = done.get_future();
+            shared->pool->submit(*shared->account, [&device, &grabbed, &done]() {
+                bool ok = false;
+                try {
+                    ok = device.retrieve(grabbed);
+                } catch (const cv::Exception &) {
+                }
+                done.set_value(ok);
+            });
+            retrieveOk = result.get();
+        }
+        if (!retrieveOk || grabbed.empty()) {
+            if (++failures > kMaxReadFailures) {
+                shared->state = static_cast<int>(State::Unavailable);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        failures = 0;
+        const qint64 nowNs = shared->probeClock.nsecsElapsed();
+        const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (shared->slots.empty()) {
+            const std::size_t frameBytes = std::max<std::size_t>(1, grabbed.total() * grabbed.elemSize());
+            shared->slots.resize(std::max<std::size_t>(1, shared->ringBytes / frameBytes));
+            shared->timestamps.resize(shared->slots.size(), 0);
+        }
+        // Обмен буферами вместо копирования: старый слот станет
+        // приёмником следующего чтения
+        std::swap(grabbed, shared->slots[shared->head]);
+        shared->timestamps[shared->head] = timestamp;
+        shared->head = (shared->head + 1) % shared->slots.size();
+        shared->count = std::min(shared->count + 1, shared->slots.size());
+
+        shared->readLatencyMs += kStatsSmoothing * (readNs / 1e6 - shared->readLatencyMs);
+        if (previousFrameNs >= 0 && nowNs > previousFrameNs) {
+            const double instantFps = 1e9 / (nowNs - previousFrameNs);
+            shared->fps += kStatsSmoothing * (instantFps - shared->fps);
+        }
+        previousFrameNs = nowNs;
+    }
+
+    device.close();
+}
@@ -0,0 +1,92 @@
+#ifndef CAPTURESOURCE_H
+#define CAPTURESOURCE_H
+
+#include <QString>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "workpool.h"
+
+// Устройство, из которого CaptureSource читает кадры: камера
+// (cv::VideoCapture) или синтетический источник имитатора. Чтение
+// разделено на ожидание кадра (grab) и его декодирование или отрисовку
+// (retrieve). Вызовы идут строго по очереди, но retrieve может
+// выполняться в другом потоке, чем grab.
+class FrameDevice
+{
+public:
+    virtual ~FrameDevice() = default;
+
+    virtual bool open() = 0;
+    // Блокирует до следующего кадра, почти не занимая процессор
+    virtual bool grab() = 0;
+    // Превращает захваченный кадр в BGR; frame может быть переиспользован
+    virtual bool retrieve(cv::Mat &frame) = 0;
+    virtual void close() {}
+
+    bool read(cv::Mat &frame)
+    {
+        return grab() && retrieve(frame);
+    }
+};
+
+// Один источник видео (камера робота). Устройство открывается и ждёт
+// кадров в собственном потоке, а декодирование каждого кадра ставится
+// задачей в пул сессии и учитывается в её ResourceAccount. Кадры
+// складываются в кольцевой буфер с метками времени. GUI-поток забирает
+// только последний кадр, а при сохранении - содержимое буфера целиком.
+// Буфер ограничен объёмом (ringBytes): число кадров в нём определяется
+// по размеру первого кадра.
+class CaptureSource
+{
+public:
+    enum class State { Probing, Running, Unavailable };
+
+    // Камера с номером deviceIndex
+    CaptureSource(const QString &name, int deviceIndex, std::size_t ringBytes);
+    // Произвольное устройство, deviceIndex() == -1
+    CaptureSource(const QString &name, std::unique_ptr<FrameDevice> device, std::size_t ringBytes);
+    ~CaptureSource();
+
+    CaptureSource(const CaptureSource &) = delete;
+    CaptureSource &operator=(const CaptureSource &) = delete;
+
+    // pool и account должны жить дольше stop()
+    void start(int probeTimeoutMs, WorkPool &pool, ResourceAccount &account);
+    void stop();
+
+    QString name() const;
+    int deviceIndex() const;
+    // Не открывшееся за probeTimeoutMs устройство - Unavailable; поток
+    // продолжает ждать, и если устройство всё же откроется, источник
+    // переходит в Running (камера подключается с опозданием)
+    State state() const;
+    // Время открытия устройства от start(), -1 если ещё не открыто
+    qint64 openTimeMs() const;
+    // Устройство открылось уже после таймаута поиска
+    bool openedLate() const;
+
+    // Копирует последний кадр в out (буфер out переиспользуется)
+    bool latestFrame(cv::Mat &out, qint64 *timestampMs = nullptr) const;
+    // Забирает накопленные кадры (от старых к новым) и очищает буфер
+    void takeRecording(std::vector<cv::Mat> &frames, std::vector<qint64> &timestamps);
+
+    qint64 lastFrameTimeMs() const;
+    double fps() const;
+    double readLatencyMs() const;
+
+private:
+    struct Shared;
+
+    static void run(std::shared_ptr<Shared> shared);
+
+    std::shared_ptr<Shared> d;
+    std::thread worker;
+};
+
+#endif // CAPTURESOURCE_H
@@ -0,0 +1,87 @@
+#include "commandlink.h"
+#include <QRegularExpression>
+
+namespace {
+
+// Пауза перед повторным подключением к серверу робота
+const int kReconnectMs = 2000;
+
+} // namespace
+
+CommandLink::CommandLink(const QString &host, quint16 port, QObject *parent)
+    : QObject(parent),
+      host(host),
+      port(port)
+{
+    socket = new QTcpSocket(this);
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    reconnectTimer = new QTimer(this);
+    reconnectTimer->setSingleShot(true);
+    reconnectTimer->setInterval(kReconnectMs);
+
+    connect(socket, &QTcpSocket::connected, this, [this]() { emit connectionChanged(true); });
+    connect(socket, &QTcpSocket::disconnected, this, [this]() {
+        emit connectionChanged(false);
+        reconnectTimer->start();
+    });
+    // Неудачное подключение не даёт disconnected - повторяем и по ошибке
+    connect(socket, &QTcpSocket::errorOccurred, this, [this]() {
+        if (socket->state() == QAbstractSocket::UnconnectedState && !reconnectTimer->isActive()) {
+            reconnectTimer->start();
+        }
+    });
+    connect(socket, &QTcpSocket::readyRead, this, &CommandLink::readReplies);
+    connect(reconnectTimer, &QTimer::timeout, this, &CommandLink::connectToRobot);
+
+    connectToRobot();
+}
+
+bool CommandLink::parseAddress(const QString &address, QString *host, quint16 *port)
+{
+    const QRegularExpressionMatch match = QRegularExpression("^(.+):(\\d+)$").match(address);
+    const int number = match.hasMatch() ? match.captured(2).toInt() : 0;
+    if (number < 1 || number > 65535) {
+        return false;
+    }
+    *host = match.captured(1);
+    *port = static_cast<quint16>(number);
+    return true;
+}
+
+QString CommandLink::address() const
+{
+    return QString("%1:%2").arg(host).arg(port);
+}
+
+bool CommandLink::isConnected() const
+{
+    return socket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool CommandLink::send(const QString &command, QString *error)
+{
+    if (!isConnected()) {
+        if (error) *error = QString("нет связи с роботом (%1)").arg(address());
+        return false;
+    }
+    socket->write(command.toUtf8() + '\n');
+    return true;
+}
+
+void CommandLink::connectToRobot()
+{
+    if (socket->state() == QAbstractSocket::UnconnectedState) {
+        socket->connectToHost(host, port);
+    }
+}
+
+void CommandLink::readReplies()
+{
+    // Неполная строка остаётся в буфере сокета до следующего readyRead
+    while (socket->canReadLine()) {
+        const QString reply = QString::fromUtf8(socket->readLine()).trimmed();
+        if (!reply.isEmpty()) {
+            emit replyReceived(reply);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef COMMANDLINK_H
+#define COMMANDLINK_H
+
+#include <QObject>
+#include <QString>
+#include <QTcpSocket>
+#include <QTimer>
+
+// Канал команд одного робота: TCP-соединение с сервером робота
+// (Wi-fi/*/Server.cpp). Команда - строка, оканчивающаяся '\n'; ответы
+// сервера (OK, BUSY, EXPIRED, CANCELLED) приходят так же построчно.
+// Сокет неблокирующий: send() только дописывает строку в буфер, GUI-поток
+// не ждёт сети. Оборванное соединение восстанавливается само.
+class CommandLink : public QObject
+{
+    Q_OBJECT
+
+public:
+    CommandLink(const QString &host, quint16 port, QObject *parent = nullptr);
+
+    // "host:port" -> host, port; false - адрес не разобран
+    static bool parseAddress(const QString &address, QString *host, quint16 *port);
+
+    QString address() const;
+    bool isConnected() const;
+    // false и *error - если связи нет и команда не отправлена
+    bool send(const QString &command, QString *error);
+
+signals:
+    void replyReceived(const QString &reply);
+    void connectionChanged(bool connected);
+
+private:
+    void connectToRobot();
+    void readReplies();
+
+    QString host;
+    quint16 port;
+    QTcpSocket *socket;
+    QTimer *reconnectTimer;
+};
+
+#endif // COMMANDLINK_H
@@ -0,0 +1,163 @@
+#ifndef LODPYRAMID_H
+#define LODPYRAMID_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Пирамида минимумов/максимумов над рядом значений. Уровень L хранит
+// min/max блоков по kFanout^(L+1) исходных отсчётов и дополняется при
+// каждом append(), поэтому min/max любого диапазона считается за
+// O(kFanout * число уровней) независимо от длины диапазона.
+// Сами значения пирамида не хранит - они передаются в range().
+// Начало ряда можно отбросить (dropFront): блоки адресуются абсолютным
+// номером отсчёта, поэтому оставшиеся блоки не пересчитываются.
+template<typename T>
+class MinMaxPyramid
+{
+public:
+    static constexpr std::size_t kFanout = 4;
+
+    void append(T value)
+    {
+        ++count;
+        std::size_t blockSize = kFanout;
+        for (std::size_t level = 0; ; ++level, blockSize *= kFanout) {
+            if (level == levels.size()) {
+                if (level > 0) {
+                    // Новый уровень нужен, когда в верхнем появился второй блок;
+                    // он собирается из блоков уровня ниже, куда value уже учтено
+                    if (bucketsEnd(level - 1) < 2) {
+                        break;
+                    }
+                    levels.push_back(merge(levels[level - 1], offsets[level - 1]));
+                    offsets.push_back(offsets[level - 1] / kFanout);
+                    continue;
+                }
+                levels.emplace_back();
+                offsets.push_back(dropped / kFanout);
+            }
+            std::vector<Bucket> &buckets = levels[level];
+            const std::size_t index = (count - 1) / blockSize - offsets[level];
+            if (index == buckets.size()) {
+                buckets.push_back({value, value});
+            } else {
+                Bucket &bucket = buckets[index];
+                bucket.min = std::min(bucket.min, value);
+                bucket.max = std::max(bucket.max, value);
+            }
+        }
+    }
+
+    void clear()
+    {
+        levels.clear();
+        offsets.clear();
+        count = 0;
+        dropped = 0;
+    }
+
+    // Отбрасывает первые n отсчётов. Блоки, где остались только
+    // отброшенные отсчёты, удаляются; блок на границе остаётся, но range()
+    // берёт блок целиком, только если весь он внутри запроса
+    void dropFront(std::size_t n)
+    {
+        dropped = std::min(count, dropped + n);
+        std::size_t blockSize = kFanout;
+        for (std::size_t level = 0; level < levels.size(); ++level, blockSize *= kFanout) {
+            const std::size_t firstKept = dropped / blockSize;
+            if (firstKept > offsets[level]) {
+                std::vector<Bucket> &buckets = levels[level];
+                buckets.erase(buckets.begin(),
+                              buckets.begin() + std::min(buckets.size(), firstKept - offsets[level]));
+                offsets[level] = firstKept;
+            }
+        }
+    }
+
+    std::size_t size() const { return count - dropped; }
+
+    // min/max отсчётов [first, last); raw - те же значения, что передавались
+    // в append(), без отброшенных dropFront()
+    std::pair<T, T> range(const std::vector<T> &raw, std::size_t first, std::size_t last) const
+    {
+        std::pair<T, T> result{raw[first], raw[first]};
+        auto take = [&result](T low, T high) {
+            result.first = std::min(result.first, low);
+            result.second = std::max(result.second, high);
+        };
+        // index - абсолютный номер отсчёта (level < 0) или блока уровня
+        auto takeAt = [&](std::ptrdiff_t level, std::size_t index) {
+            if (level < 0) {
+                take(raw[index - dropped], raw[index - dropped]);
+            } else {
+                const Bucket &bucket = levels[level][index - offsets[level]];
+                take(bucket.min, bucket.max);
+            }
+        };
+
+        first += dropped;
+        last += dropped;
+
+        // Поднимаемся по уровням, снимая с краёв невыровненные блоки
+        std::size_t blockSize = 1;
+        for (std::ptrdiff_t level = -1; ; ++level) {
+            const std::size_t nextSize = blockSize * kFanout;
+            const std::size_t alignedFirst = (first + nextSize - 1) / nextSize * nextSize;
+            const std::size_t alignedLast = last / nextSize * nextSize;
+            if (static_cast<std::size_t>(level + 1) >= levels.size() || alignedFirst >= alignedLast) {
+                for (std::size_t i = first; i < last; i += blockSize) {
+                    takeAt(level, i / blockSize);
+                }
+                break;
+            }
+            for (; first < alignedFirst; first += blockSize) {
+                takeAt(level, first / blockSize);
+            }
+            for (; last > alignedLast; last -= blockSize) {
+                takeAt(level, (last - blockSize) / blockSize);
+            }
+            blockSize = nextSize;
+        }
+        return result;
+    }
+
+private:
+    struct Bucket
+    {
+        T min;
+        T max;
+    };
+
+    // Абсолютный номер блока после последнего на уровне level
+    std::size_t bucketsEnd(std::size_t level) const
+    {
+        return offsets[level] + levels[level].size();
+    }
+
+    // lower начинается с блока номер offset; группы по kFanout выровнены
+    // по абсолютным номерам
+    static std::vector<Bucket> merge(const std::vector<Bucket> &lower, std::size_t offset)
+    {
+        std::vector<Bucket> upper;
+        upper.reserve(lower.size() / kFanout + 1);
+        for (std::size_t i = 0; i < lower.size(); ++i) {
+            if (i == 0 || (offset + i) % kFanout == 0) {
+                upper.push_back(lower[i]);
+            } else {
+                upper.back().min = std::min(upper.back().min, lower[i].min);
+                upper.back().max = std::max(upper.back().max, lower[i].max);
+            }
+        }
+        return upper;
+    }
+
+    std::vector<std::vector<Bucket>> levels;
+    // Абсолютный номер первого хранимого блока каждого уровня
+    std::vector<std::size_t> offsets;
+    std::size_t count = 0;      // всего добавлено отсчётов
+    std::size_t dropped = 0;    // из них отброшено с начала
+};
+
+#endif // LODPYRAMID_H
@@ -1,11 +1,136 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QTimer>
+#include <climits>
+#include <cstring>
 #include "mainwindow.h"
+#include "telemetrycodec.h"
+
+namespace {
+
+// Ключи имитатора: pult --sim-seed 7 --sim-rate 1000 --sim-faults 6
+//                       --sim-video 1280x720@30 --quit-after 60
+bool parseSimulatorConfig(const QCommandLineParser &parser, SimulatorConfig &config, int &quitAfterS)
+{
+    bool ok = true;
+    config.seed = parser.value("sim-seed").toULongLong(&ok);
+    if (!ok) {
+        qCritical() << "--sim-seed: ожидается целое число";
+        return false;
+    }
+    config.sensorRateHz = parser.value("sim-rate").toInt(&ok);
+    if (!ok || config.sensorRateHz < 1 || config.sensorRateHz > 10000) {
+        qCritical() << "--sim-rate: ожидается частота 1..10000 Гц";
+        return false;
+    }
+    config.faultsPerMinute = parser.value("sim-faults").toDouble(&ok);
+    if (!ok || config.faultsPerMinute < 0) {
+        qCritical() << "--sim-faults: ожидается неотрицательное число";
+        return false;
+    }
+    if (parser.isSet("sim-video")) {
+        const QRegularExpressionMatch match =
+            QRegularExpression("^(\\d+)x(\\d+)@(\\d+)$").match(parser.value("sim-video"));
+        if (!match.hasMatch() || match.captured(1).toInt() < 16 || match.captured(2).toInt() < 16
+            || match.captured(3).toInt() < 1) {
+            qCritical() << "--sim-video: ожидается <ширина>x<высота>@<fps>, например 1280x720@30";
+            return false;
+        }
+        config.syntheticVideo = true;
+        config.videoSize = cv::Size(match.captured(1).toInt(), match.captured(2).toInt());
+        config.videoFps = match.captured(3).toInt();
+    }
+    quitAfterS = 0;
+    if (parser.isSet("quit-after")) {
+        quitAfterS = parser.value("quit-after").toInt(&ok);
+        if (!ok || quitAfterS < 1 || quitAfterS > INT_MAX / 1000) {
+            qCritical() << "--quit-after: ожидается время 1..2147483 секунд";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Режимы без окна работают и на машине без дисплея (CI), где
+// QApplication не создаётся
+QCoreApplication *createApplication(int &argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench-codec") == 0 || std::strcmp(argv[i], "--sim-check") == 0) {
+            return new QCoreApplication(argc, argv);
+        }
+    }
+    return new QApplication(argc, argv);
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    QScopedPointer<QCoreApplication> app(createApplication(argc, argv));
+
+    // pult --bench-codec [число отсчётов] - замер кодека телеметрии без окна
+    const QStringList args = app->arguments();
+    if (args.size() > 1 && args.at(1) == "--bench-codec") {
+        const std::size_t samples = args.size() > 2 ? args.at(2).toULongLong() : 1000000;
+        return telemetry::runCodecBenchmark(samples);
+    }
     
-    MainWindow window;
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOptions({
+        {"sim-seed", "Seed имитатора датчиков и видео.", "seed", "1"},
+        {"sim-rate", "Частота датчиков имитатора, Гц.", "hz", QString::number(telemetry::maxRateHz())},
+        {"sim-faults", "Сбоев имитатора в минуту.", "count", "0"},
+        {"sim-video", "Синтетическое видео вместо камер.", "WxH@FPS"},
+        {"quit-after", "Закрыть пульт через заданное время (прогон без оператора).", "seconds"},
+        {"robots", "Число роботов на пульте.", "count", "1"},
+        {"robot", "Адрес сервера робота host:port; ключ повторяется по порядку роботов.", "host:port"},
+        {"sim-check", "Проверить воспроизводимость имитатора на заданном числе отсчётов "
+                      "и выйти (без окна).", "samples"},
+    });
+    parser.process(*app);
+
+    SimulatorConfig simulation;
+    int quitAfterS = 0;
+    if (!parseSimulatorConfig(parser, simulation, quitAfterS)) {
+        return 1;
+    }
+    bool ok = true;
+    // pult --sim-check 1000000 --sim-seed 7 --sim-rate 1000 --sim-faults 6
+    if (parser.isSet("sim-check")) {
+        const qlonglong samples = parser.value("sim-check").toLongLong(&ok);
+        if (!ok || samples < 1) {
+            qCritical() << "--sim-check: ожидается положительное число отсчётов";
+            return 1;
+        }
+        return runSimulatorCheck(simulation, static_cast<std::size_t>(samples));
+    }
+    const int robots = parser.value("robots").toInt(&ok);
+    if (!ok || robots < 1 || robots > 16) {
+        qCritical() << "--robots: ожидается число 1..16";
+        return 1;
+    }
+
+    // pult --robots 2 --robot 192.168.0.10:8080 --robot 192.168.0.11:8080
+    const QStringList robotAddresses = parser.values("robot");
+    if (robotAddresses.size() > robots) {
+        qCritical() << "--robot: адресов больше, чем роботов (--robots)";
+        return 1;
+    }
+    for (const QString &address : robotAddresses) {
+        QString host;
+        quint16 port = 0;
+        if (!CommandLink::parseAddress(address, &host, &port)) {
+            qCritical().noquote() << "--robot: ожидается host:port, получено" << address;
+            return 1;
+        }
+    }
+
+    MainWindow window(simulation, robots, robotAddresses);
     window.setWindowTitle("Пульт оператора ТУПР v1.0");
     window.resize(1200, 720); 
     window.show();
@@ -13,6 +138,12 @@ int main(int argc, char *argv[])
     window.activateWindow();
     window.raise();
     window.setFocus();
+
+    // При закрытии окна в журнал выводятся метрики отзывчивости и
+    // итоговый расход ресурсов каждой сессии
+    if (quitAfterS > 0) {
+        QTimer::singleShot(quitAfterS * 1000, &window, &QWidget::close);
+    }
     
-    return app.exec();
+    return app->exec();
 }
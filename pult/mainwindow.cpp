@@ -3,40 +3,122 @@
 #include <QPainter>
 #include <QDir>
 #include <QKeyEvent>
+#include <QFileDialog>
+#include <QSignalBlocker>
+#include <QStatusBar>
+#include <QDebug>
+#include <QStringList>
+#include <algorithm>
 
-MainWindow::MainWindow(QWidget *parent)
+namespace {
+
+QString formatPosition(qint64 ms)
+{
+    const qint64 seconds = ms / 1000;
+    return QString("%1:%2").arg(seconds / 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+// Датчики опрашиваются не чаще кадра экрана; при высокой частоте
+// за один опрос приходит пачка отсчётов
+const int kMinSensorPollMs = 16;
+// Шаг seed между роботами: у каждого свои данные имитатора
+const quint64 kSessionSeedStride = 1000;
+
+// Сколько ждать открытия камеры, прежде чем считать её недоступной
+const int kCameraProbeTimeoutMs = 3000;
+// Объём буферов записи всех роботов вместе: поровну на сессию, в сессии
+// половина - мозаике, половина - поровну камерам. Длина записи поэтому
+// падает с числом роботов, а память - нет
+const std::size_t kRecordBudgetBytes = std::size_t(1) << 30;
+// Пульс сторожа цикла событий и порог, с которого задержка - зависание
+const int kWatchdogHeartbeatMs = 20;
+const int kStallThresholdMs = 100;
+// Сколько держится подтверждение команды в строке состояния
+const int kStatusMessageMs = 3000;
+
+struct CameraConfig
+{
+    const char *name;
+    int deviceIndex;
+};
+
+// Камеры робота: передняя, задняя и камера манипулятора
+const CameraConfig kCameras[] = {
+    {"Передняя", 0},
+    {"Задняя", 1},
+    {"Манипулятор", 2},
+};
+
+} // namespace
+
+MainWindow::MainWindow(const SimulatorConfig &simulation, int robotCount,
+                       const QStringList &robotAddresses, QWidget *parent)
     : QMainWindow(parent),
       gen(rd()),
-      distDist(5.0, 200.0),
-      tempDist(10.0, 40.0),
-      battDist(60, 100),
-      humDist(30, 80),
       signalDist(40, 100),
-      gpsDist(0.0, 0.001),
       highQuality(true),
-      distance(100.0),
-      temperature(25.0),
-      humidity(55),
+      replayMode(false),
+      currentSession(0),
+      robotCount(std::max(1, robotCount)),
+      robotAddresses(robotAddresses),
+      reportedPoolBusyNs(0),
+      reportedPoolUptimeNs(0),
+      simulation(simulation),
+      lastLogMs(0),
       isConnected(true),
-      cameraAvailable(false),
-      maxFramesInBuffer(900)  // ~30 секунд при 30 FPS
+      firstFrameLogged(false)
 {
+    startupClock.start();
+
+    replay = new SessionReplay(this);
+    connect(replay, &SessionReplay::frameReady, this, &MainWindow::showFrame);
+    connect(replay, &SessionReplay::sampleReady, this, &MainWindow::applyTelemetry);
+    connect(replay, &SessionReplay::historyLoaded, this, &MainWindow::loadReplayHistory);
+
     setupUI();
-    initCamera();
+
+    // Сторож запускается до камер, чтобы видеть и задержки старта
+    watchdog = new UiWatchdog(this);
+    connect(watchdog, &UiWatchdog::stalled, this, [this](qint64 durationMs, const QString &slot) {
+        qWarning().noquote() << "[UI] stall" << durationMs << "ms in" << slot;
+        telemetryLog->append(QString("[UI] Интерфейс не отвечал %1 мс: %2").arg(durationMs).arg(slot));
+    });
+    watchdog->start(kWatchdogHeartbeatMs, kStallThresholdMs);
+
+    initSessions();
 
     setFocusPolicy(Qt::StrongFocus);
     setFocus();
     centralWidget->installEventFilter(this);
     
-    // Таймер обновления датчиков (каждые 500 мс)
+    // Таймер опроса датчиков: период отсчёта, но не чаще kMinSensorPollMs
     sensorUpdateTimer = new QTimer(this);
     connect(sensorUpdateTimer, &QTimer::timeout, this, &MainWindow::updateSensorData);
-    sensorUpdateTimer->start(500);
+    sensorUpdateTimer->start(std::max(kMinSensorPollMs, 1000 / simulation.sensorRateHz));
     
     // Таймер видео (каждые 33 мс ≈ 30 FPS)
     videoTimer = new QTimer(this);
     connect(videoTimer, &QTimer::timeout, this, &MainWindow::updateVideoFrame);
     videoTimer->start(33);
+
+    // Графики телеметрии перерисовываются с частотой ~60 FPS
+    plotTimer = new QTimer(this);
+    plotTimer->setTimerType(Qt::PreciseTimer);
+    connect(plotTimer, &QTimer::timeout, this, &MainWindow::refreshPlots);
+    plotTimer->start(16);
+
+    // Статистика камер и расход ресурсов сессий (раз в секунду)
+    cameraStatsTimer = new QTimer(this);
+    connect(cameraStatsTimer, &QTimer::timeout, this, &MainWindow::updateCameraStats);
+    connect(cameraStatsTimer, &QTimer::timeout, this, &MainWindow::updateResponsiveness);
+    cameraStatsTimer->start(1000);
+
+    // Первая итерация цикла событий - окно показано и принимает ввод
+    QTimer::singleShot(0, this, [this]() {
+        const qint64 elapsed = startupClock.elapsed();
+        qInfo() << "[STARTUP] time-to-interactive:" << elapsed << "ms";
+        telemetryLog->append(QString("[STARTUP] Интерфейс готов: %1 мс").arg(elapsed));
+    });
     
     // Таймер проверки соединения
     /*connectionTimer = new QTimer(this);
@@ -59,122 +141,271 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    if (camera.isOpened()) {
-        camera.release();
+    watchdog->stop();
+    qInfo().noquote() << "[UI]" << watchdog->report();
+    for (const auto &session : sessions) {
+        qInfo().noquote() << "[SESSION]" << session->resourceTotals();
     }
+    // Сессии дожидаются своих задач в пуле и останавливают камеры
+    sessions.clear();
 }
 
-void MainWindow::initCamera()
+void MainWindow::initSessions()
 {
-    // Попытка открыть камеру (0 - встроенная камера)
-    camera.open(0);
-    
-    if (camera.isOpened()) {
-        cameraAvailable = true;
-        telemetryLog->append("[CAMERA] Камера успешно подключена");
-    } else {
-        cameraAvailable = false;
-        telemetryLog->append("[CAMERA] Камера не найдена - используется симуляция");
-    }
-}
+    // Заставка симуляции рисуется один раз и дальше берётся из кэша
+    simulatedFrame = QPixmap(640, 480);
+    simulatedFrame.fill(QColor(26, 26, 26));
+    QPainter painter(&simulatedFrame);
+    painter.setPen(QColor(100, 255, 100));
+    painter.setFont(QFont("Arial", 20));
+    painter.drawText(simulatedFrame.rect(), Qt::AlignCenter,
+                     "VIDEO STREAM\n[Simulated]\nКамера не подключена");
+    painter.end();
 
-void MainWindow::updateVideoFrame()
-{
-    if (cameraAvailable && camera.isOpened()) {
-        cv::Mat frame;
-        camera >> frame;
+    // Кадры собираются в задачах WorkPool - функции OpenCV внутри них
+    // не должны раздавать работу ещё и собственному пулу потоков
+    cv::setNumThreads(0);
+
+    const std::size_t sessionBytes = kRecordBudgetBytes / robotCount;
+    const std::size_t mosaicBytes = sessionBytes / 2;
+    const std::size_t cameraBytes = sessionBytes / 2 / std::size(kCameras);
+    telemetryLog->append(QString("[POOL] Роботов: %1, потоков пула: %2, буфер записи на робота: %3 МБ")
+                         .arg(robotCount).arg(workPool.threadCount()).arg(sessionBytes >> 20));
+    // Датчики: пока связи с роботами нет, источник - имитатор
+    telemetryLog->append(QString("[SIM] seed %1, %2 Гц, сбоев в минуту: %3")
+                         .arg(simulation.seed).arg(simulation.sensorRateHz).arg(simulation.faultsPerMinute));
+    // Открытие V4L2-устройства может занимать секунды или зависнуть,
+    // поэтому каждая камера открывается и читается в своём потоке,
+    // а окно показывается сразу
+    telemetryLog->append(simulation.syntheticVideo
+                         ? QString("[CAMERA] Синтетическое видео %1x%2, %3 FPS")
+                               .arg(simulation.videoSize.width).arg(simulation.videoSize.height)
+                               .arg(simulation.videoFps)
+                         : QString("[CAMERA] Поиск камер..."));
 
-        if (!frame.empty()) {
-            cv::Mat outFrame = frame;
-            // Обрезаем/снижаем качество только если надо
-            if (!highQuality) {
-                // Снизить разрешение, вызывается только для низкого качества
-                cv::resize(frame, outFrame, cv::Size(128, 72));
+    for (int robot = 0; robot < robotCount; ++robot) {
+        SimulatorConfig config = simulation;
+        config.seed = simulation.seed + robot * kSessionSeedStride;
+
+        std::vector<std::unique_ptr<CaptureSource>> cameras;
+        for (const CameraConfig &camera : kCameras) {
+            const QString name = QString::fromUtf8(camera.name);
+            if (config.syntheticVideo) {
+                // Своя картинка у каждой камеры, но всё определяется seed
+                cameras.push_back(std::make_unique<CaptureSource>(
+                    name,
+                    std::make_unique<SyntheticCamera>(config.seed + camera.deviceIndex,
+                                                      config.videoSize, config.videoFps),
+                    cameraBytes));
+            } else if (robot == 0) {
+                // Камеры этого компьютера - у первого робота, видео
+                // остальных придёт по их каналам связи
+                cameras.push_back(std::make_unique<CaptureSource>(name, camera.deviceIndex, cameraBytes));
             }
+        }
 
-            // Конвертация BGR -> RGB для Qt
-            cv::cvtColor(outFrame, outFrame, cv::COLOR_BGR2RGB);
-
-            QImage qimg(outFrame.data, outFrame.cols, outFrame.rows, outFrame.step, QImage::Format_RGB888);
-            QPixmap pixmap = QPixmap::fromImage(qimg).scaled(
-                videoLabel->size(),
-                Qt::KeepAspectRatio,
-                Qt::SmoothTransformation
-            );
-            videoLabel->setPixmap(pixmap);
-
-            // Записываем (если надо) всегда тот же outFrame
-            videoFrameBuffer.enqueue(outFrame.clone());
-            if (videoFrameBuffer.size() > maxFramesInBuffer) {
-                videoFrameBuffer.dequeue();
+        sessions.push_back(std::make_unique<RobotSession>(
+            robot + 1, QString("Робот %1").arg(robot + 1),
+            std::make_unique<SensorSimulator>(config), std::move(cameras), mosaicBytes, workPool));
+        RobotSession *session = sessions.back().get();
+        session->startCameras(kCameraProbeTimeoutMs);
+
+        connect(session, &RobotSession::frameReady, this, [this, session](const QImage &image) {
+            // Кадр мог прийти уже после переключения робота
+            if (!replayMode && session == &activeSession()) {
+                showImage(image);
+            }
+        });
+        connect(session, &RobotSession::recordingFinished, this,
+                [this, session](const QString &path, int frameCount, const QString &error) {
+            if (!error.isEmpty()) {
+                QMessageBox::critical(this, "Ошибка", QString("%1: %2").arg(session->name()).arg(error));
+                return;
             }
+            telemetryLog->append(QString("[VIDEO] %1: видеопоток сохранен: %2 (%3 кадров)")
+                                 .arg(session->name()).arg(path).arg(frameCount));
+            QMessageBox::information(this, "Видеопоток сохранен",
+                                     QString("Видеопоток успешно сохранен:\n%1\n\nКадров: %2")
+                                     .arg(path).arg(frameCount));
+        });
+        connect(session, &RobotSession::commandReply, this, [this, session](const QString &reply) {
+            telemetryLog->append(QString("[ROBOT] %1: %2").arg(session->name()).arg(reply));
+            // Отказы сервера оператор должен увидеть, а не искать в логе
+            if (reply.startsWith("BUSY") || reply.startsWith("EXPIRED")
+                || reply.startsWith("CANCELLED") || reply.startsWith("ERROR")) {
+                statusBar()->showMessage(QString("%1: %2").arg(session->name()).arg(reply), kStatusMessageMs);
+            }
+        });
+        connect(session, &RobotSession::linkChanged, this, [this, session](bool connected) {
+            telemetryLog->append(QString("[ROBOT] %1: связь %2 (%3)")
+                                 .arg(session->name())
+                                 .arg(connected ? "установлена" : "потеряна")
+                                 .arg(session->commandLink()->address()));
+            if (session == &activeSession()) {
+                showLinkStatus();
+            }
+        });
+        if (robot < robotAddresses.size()) {
+            QString host;
+            quint16 port = 0;
+            CommandLink::parseAddress(robotAddresses[robot], &host, &port);
+            session->connectRobot(host, port);
+        } else {
+            telemetryLog->append(QString("[ROBOT] %1: адрес не задан (--robot), команды не отправляются")
+                                 .arg(session->name()));
         }
+        robotBox->addItem(session->name());
+    }
+    showLinkStatus();
+}
+
+// Состояние канала команд активного робота
+void MainWindow::showLinkStatus()
+{
+    const CommandLink *link = activeSession().commandLink();
+    if (!link) {
+        connectionStatusLabel->setText("Связь: <font color='gray'>НЕТ КАНАЛА</font>");
+    } else if (link->isConnected()) {
+        connectionStatusLabel->setText("Связь: <font color='green'>УСТАНОВЛЕНА</font>");
     } else {
-        // Имитация/симуляция
-        QPixmap videoFrame(640, 480);
-        videoFrame.fill(QColor(26, 26, 26));
-        QPainter painter(&videoFrame);
-        painter.setPen(QColor(100, 255, 100));
-        painter.setFont(QFont("Arial", 20));
-        painter.drawText(videoFrame.rect(), Qt::AlignCenter,
-                        "VIDEO STREAM\n[Simulated]\nКамера не подключена");
-        videoLabel->setPixmap(videoFrame);
+        connectionStatusLabel->setText("Связь: <font color='red'>ПОТЕРЯНА</font>");
     }
 }
 
+RobotSession &MainWindow::activeSession()
+{
+    return *sessions[currentSession];
+}
 
-void MainWindow::saveVideoStream()
+void MainWindow::selectSession(int index)
 {
-    if (videoFrameBuffer.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Нет кадров для сохранения");
+    if (index < 0 || index >= static_cast<int>(sessions.size())) {
         return;
     }
-    
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString filename = QString("video_%1.mp4").arg(timestamp);
-    
-    // Создаём папку videos если её нет
-    QDir dir;
-    if (!dir.exists("videos")) {
-        dir.mkdir("videos");
+    currentSession = index;
+    rebuildCameraControls();
+    cameraStatsLabel->clear();
+    showLinkStatus();
+
+    RobotSession &session = activeSession();
+    if (!replayMode && session.hasTelemetry()) {
+        showTelemetry(session.latestSample());
     }
-    
-    QString filepath = QString("videos/%1").arg(filename);
-    
-    // Параметры видеозаписи
-    int codec = cv::VideoWriter::fourcc('m', 'p', '4', 'v');  // MP4V codec
-    double fps = 30.0;
-    cv::Size frameSize(1280, 720);
-    
-    // Открываем VideoWriter
-    cv::VideoWriter videoWriter(filepath.toStdString(), codec, fps, frameSize, true);
-    
-    if (!videoWriter.isOpened()) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось открыть файл для записи");
-        return;
+    telemetryLog->append(QString("[ROBOT] Управление: %1").arg(session.name()));
+}
+
+// Раскладка и источник записи - по камерам активного робота
+void MainWindow::rebuildCameraControls()
+{
+    const QSignalBlocker layoutBlocker(mosaicLayoutBox);
+    const QSignalBlocker exportBlocker(exportSourceBox);
+    mosaicLayoutBox->clear();
+    mosaicLayoutBox->addItem("Мозаика");
+    exportSourceBox->clear();
+    exportSourceBox->addItem("Мозаика");
+
+    RobotSession &session = activeSession();
+    for (const auto &camera : session.cameras()) {
+        mosaicLayoutBox->addItem(QString("Основная: %1").arg(camera->name()));
+        exportSourceBox->addItem(camera->name());
     }
-    
-    // Записываем все кадры из буфера
-    int frameCount = 0;
-    while (!videoFrameBuffer.isEmpty()) {
-        cv::Mat frame = videoFrameBuffer.dequeue();
-        
-        // Изменяем размер кадра если нужно
-        if (frame.cols != frameSize.width || frame.rows != frameSize.height) {
-            cv::resize(frame, frame, frameSize);
+    mosaicLayoutBox->setCurrentIndex(session.mosaicLayout());
+}
+
+void MainWindow::updateVideoFrame()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // Кадры всех роботов собираются в пуле (для записи),
+    // на экран идёт только кадр активного
+    bool activeRunning = false;
+    for (const auto &session : sessions) {
+        const bool active = session.get() == &activeSession();
+        const bool running = session->captureFrame(active, !highQuality, videoLabel->size());
+        if (active) {
+            activeRunning = running;
         }
-        
-        videoWriter.write(frame);
-        frameCount++;
     }
-    
-    videoWriter.release();
-    
-    telemetryLog->append(QString("[VIDEO] Видеопоток сохранен: %1 (%2 кадров)")
-                         .arg(filepath).arg(frameCount));
-    QMessageBox::information(this, "Видеопоток сохранен", 
-                            QString("Видеопоток успешно сохранен:\n%1\n\nКадров: %2")
-                            .arg(filepath).arg(frameCount));
+
+    if (!activeRunning && videoLabel->pixmap().cacheKey() != simulatedFrame.cacheKey()) {
+        // Имитация/симуляция: заставка уже нарисована, перерисовываем только при смене
+        videoLabel->setPixmap(simulatedFrame);
+    }
+}
+
+void MainWindow::updateCameraStats()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    QStringList resources;
+    for (const auto &session : sessions) {
+        QStringList events;
+        const QString status = session->cameraStatus(events);
+        for (const QString &event : events) {
+            telemetryLog->append(sessions.size() > 1
+                                 ? QString("[CAMERA] %1, %2").arg(session->name()).arg(event)
+                                 : QString("[CAMERA] %1").arg(event));
+        }
+        if (session.get() == &activeSession()) {
+            cameraStatsLabel->setText(status);
+        }
+        resources << session->resourceSummary();
+    }
+
+    // Загрузка пула за прошедший период: доля всех потоков
+    const qint64 busyNs = workPool.busyNs();
+    const qint64 uptimeNs = workPool.uptimeNs();
+    const double load = 100.0 * (busyNs - reportedPoolBusyNs)
+                        / std::max<qint64>(1, (uptimeNs - reportedPoolUptimeNs) * workPool.threadCount());
+    reportedPoolBusyNs = busyNs;
+    reportedPoolUptimeNs = uptimeNs;
+    resources << QString("Пул: %1 потоков, загрузка %2%").arg(workPool.threadCount()).arg(load, 0, 'f', 1);
+    sessionStatsLabel->setText(resources.join('\n'));
+}
+
+void MainWindow::updateResponsiveness()
+{
+    responsivenessLabel->setText(watchdog->summary());
+}
+
+void MainWindow::showFrame(const cv::Mat &frame)
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // Конвертация BGR -> RGB для Qt
+    cv::Mat rgbFrame;
+    cv::cvtColor(frame, rgbFrame, cv::COLOR_BGR2RGB);
+
+    QImage qimg(rgbFrame.data, rgbFrame.cols, rgbFrame.rows, rgbFrame.step, QImage::Format_RGB888);
+    showImage(qimg.scaled(
+        videoLabel->size(),
+        Qt::KeepAspectRatio,
+        Qt::SmoothTransformation
+    ));
+}
+
+void MainWindow::showImage(const QImage &image)
+{
+    videoLabel->setPixmap(QPixmap::fromImage(image));
+
+    if (!firstFrameLogged) {
+        firstFrameLogged = true;
+        const qint64 elapsed = startupClock.elapsed();
+        qInfo() << "[STARTUP] time-to-first-frame:" << elapsed << "ms";
+        telemetryLog->append(QString("[STARTUP] Первый кадр: %1 мс").arg(elapsed));
+    }
+}
+
+
+void MainWindow::saveVideoStream()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // Кадры и телеметрия забираются сразу, файлы пишутся в пуле;
+    // об окончании сообщит RobotSession::recordingFinished
+    RobotSession &session = activeSession();
+    QString error;
+    if (!session.saveRecording(exportSourceBox->currentIndex(), &error)) {
+        QMessageBox::warning(this, "Ошибка", error);
+        return;
+    }
+    telemetryLog->append(QString("[VIDEO] %1: сохранение видеопотока...").arg(session.name()));
 }
 
 
@@ -196,6 +427,7 @@ void MainWindow::setupUI()
     // Правая панель - телеметрия и статус
     QVBoxLayout *rightPanel = new QVBoxLayout();
     rightPanel->addLayout(createTelemetryPanel());
+    rightPanel->addLayout(createPlotPanel());
     rightPanel->addLayout(createStatusPanel());
     
     mainLayout->addLayout(leftPanel, 2);
@@ -227,12 +459,81 @@ QVBoxLayout* MainWindow::createVideoPanel()
     videoControls->addWidget(btnToggleQuality);
     videoControls->addWidget(videoQualityLabel);
     videoLayout->addLayout(videoControls);
+
+    // Камеры: раскладка мозаики, источник записи и статистика
+    QHBoxLayout *cameraControls = new QHBoxLayout();
+    // Списки заполняются по камерам активного робота (rebuildCameraControls)
+    mosaicLayoutBox = new QComboBox();
+    exportSourceBox = new QComboBox();
+    cameraControls->addWidget(new QLabel("Вид:"));
+    cameraControls->addWidget(mosaicLayoutBox);
+    cameraControls->addWidget(new QLabel("Запись:"));
+    cameraControls->addWidget(exportSourceBox);
+    cameraControls->addStretch();
+    videoLayout->addLayout(cameraControls);
+
+    cameraStatsLabel = new QLabel();
+    cameraStatsLabel->setStyleSheet("color: #666;");
+    videoLayout->addWidget(cameraStatsLabel);
+
+    // Воспроизведение записанной сессии
+    QHBoxLayout *replayControls = new QHBoxLayout();
+    btnOpenReplay = new QPushButton("Открыть запись");
+    btnReplayPlay = new QPushButton("▶");
+    btnReplayPlay->setFixedWidth(40);
+    replaySlider = new QSlider(Qt::Horizontal);
+    replaySpeedBox = new QComboBox();
+    for (double speed : {0.25, 0.5, 1.0, 2.0, 4.0, 8.0}) {
+        replaySpeedBox->addItem(QString("x%1").arg(speed), speed);
+    }
+    replaySpeedBox->setCurrentIndex(2);
+    replayPositionLabel = new QLabel("--:-- / --:--");
+    btnReplayLive = new QPushButton("Прямой эфир");
+
+    replayControls->addWidget(btnOpenReplay);
+    replayControls->addWidget(btnReplayPlay);
+    replayControls->addWidget(replaySlider, 1);
+    replayControls->addWidget(replayPositionLabel);
+    replayControls->addWidget(replaySpeedBox);
+    replayControls->addWidget(btnReplayLive);
+    videoLayout->addLayout(replayControls);
+
+    btnReplayPlay->setEnabled(false);
+    replaySlider->setEnabled(false);
+    replaySpeedBox->setEnabled(false);
+    btnReplayLive->setEnabled(false);
     
     videoGroup->setLayout(videoLayout);
     
     connect(btnSaveFrame, &QPushButton::clicked, this, &MainWindow::saveSnapshot);
     connect(btnSaveVideoStream, &QPushButton::clicked, this, &MainWindow::saveVideoStream);
     connect(btnToggleQuality, &QPushButton::clicked, this, &MainWindow::toggleVideoQuality);
+    connect(mosaicLayoutBox, &QComboBox::currentIndexChanged, this, [this](int index) {
+        activeSession().setMosaicLayout(index);
+    });
+    connect(btnOpenReplay, &QPushButton::clicked, this, &MainWindow::openReplay);
+    connect(btnReplayPlay, &QPushButton::clicked, this, &MainWindow::toggleReplayPlayback);
+    connect(btnReplayLive, &QPushButton::clicked, this, &MainWindow::closeReplay);
+    // Пока ползунок тянут - только кадр и текущий отсчёт, история окна
+    // графиков загружается один раз, когда его отпустят
+    connect(replaySlider, &QSlider::sliderMoved, replay, &SessionReplay::scrub);
+    connect(replaySlider, &QSlider::sliderReleased, this, [this]() {
+        replay->seek(replaySlider->value());
+    });
+    connect(replaySpeedBox, &QComboBox::currentIndexChanged, this, [this]() {
+        replay->setSpeed(replaySpeedBox->currentData().toDouble());
+    });
+    connect(replay, &SessionReplay::positionChanged, this, [this](qint64 position) {
+        if (!replaySlider->isSliderDown()) {
+            replaySlider->setValue(static_cast<int>(position));
+        }
+        replayPositionLabel->setText(QString("%1 / %2")
+                                     .arg(formatPosition(position))
+                                     .arg(formatPosition(replay->durationMs())));
+    });
+    connect(replay, &SessionReplay::finished, this, [this]() {
+        btnReplayPlay->setText("▶");
+    });
     
     QVBoxLayout *result = new QVBoxLayout();
     result->addWidget(videoGroup);
@@ -244,6 +545,13 @@ QVBoxLayout* MainWindow::createControlPanel()
 {
     QGroupBox *controlGroup = new QGroupBox("Управление роботом");
     QVBoxLayout *controlLayout = new QVBoxLayout();
+
+    // Команды и видео относятся к выбранному роботу
+    QHBoxLayout *robotRow = new QHBoxLayout();
+    robotBox = new QComboBox();
+    robotRow->addWidget(new QLabel("Робот:"));
+    robotRow->addWidget(robotBox, 1);
+    controlLayout->addLayout(robotRow);
     
     // Кнопки управления движением
     QGridLayout *moveButtons = new QGridLayout();
@@ -297,6 +605,7 @@ QVBoxLayout* MainWindow::createControlPanel()
     connect(btnSound, &QPushButton::clicked, this, &MainWindow::soundSignal);
     connect(btnSendPacket, &QPushButton::clicked, this, &MainWindow::sendPacketCommand);
     connect(btnMoveToObstacle, &QPushButton::clicked, this, &MainWindow::moveToObstacle);
+    connect(robotBox, &QComboBox::currentIndexChanged, this, &MainWindow::selectSession);
     
     QVBoxLayout *result = new QVBoxLayout();
     result->addWidget(controlGroup);
@@ -308,29 +617,21 @@ QVBoxLayout* MainWindow::createTelemetryPanel()
     QGroupBox *telemetryGroup = new QGroupBox("Телеметрия датчиков");
     QGridLayout *telemetryLayout = new QGridLayout();
     
-    telemetryLayout->addWidget(new QLabel("Расстояние (см):"), 0, 0);
-    distanceSensorDisplay = new QLCDNumber();
-    distanceSensorDisplay->setDigitCount(6);
-    distanceSensorDisplay->setSegmentStyle(QLCDNumber::Flat);
-    telemetryLayout->addWidget(distanceSensorDisplay, 0, 1);
-    
-    telemetryLayout->addWidget(new QLabel("Температура (°C):"), 1, 0);
-    temperatureDisplay = new QLCDNumber();
-    temperatureDisplay->setDigitCount(5);
-    temperatureDisplay->setSegmentStyle(QLCDNumber::Flat);
-    telemetryLayout->addWidget(temperatureDisplay, 1, 1);
-    
-    
-    telemetryLayout->addWidget(new QLabel("Влажность (%):"), 3, 0);
-    humidityDisplay = new QLCDNumber();
-    humidityDisplay->setDigitCount(3);
-    humidityDisplay->setSegmentStyle(QLCDNumber::Flat);
-    telemetryLayout->addWidget(humidityDisplay, 3, 1);
-    
+    // Индикаторы строятся по схеме каналов
+    telemetry::forEachChannel([&](auto index, const auto &channel) {
+        constexpr int row = static_cast<int>(decltype(index)::value);
+        telemetryLayout->addWidget(new QLabel(QString("%1 (%2):").arg(channel.label).arg(channel.units)), row, 0);
+        QLCDNumber *display = new QLCDNumber();
+        display->setDigitCount(channel.digits);
+        display->setSegmentStyle(QLCDNumber::Flat);
+        telemetryLayout->addWidget(display, row, 1);
+        channelDisplays[row] = display;
+    });
     
-    telemetryLayout->addWidget(new QLabel("Время:"), 6, 0);
+    const int timeRow = static_cast<int>(telemetry::kChannelCount);
+    telemetryLayout->addWidget(new QLabel("Время:"), timeRow, 0);
     timestampLabel = new QLabel();
-    telemetryLayout->addWidget(timestampLabel, 6, 1);
+    telemetryLayout->addWidget(timestampLabel, timeRow, 1);
     
     telemetryGroup->setLayout(telemetryLayout);
     
@@ -339,6 +640,74 @@ QVBoxLayout* MainWindow::createTelemetryPanel()
     return result;
 }
 
+QVBoxLayout* MainWindow::createPlotPanel()
+{
+    QGroupBox *plotGroup = new QGroupBox("История телеметрии");
+    QVBoxLayout *plotLayout = new QVBoxLayout();
+
+    QHBoxLayout *windowControls = new QHBoxLayout();
+    plotWindowBox = new QComboBox();
+    plotWindowBox->addItem("1 мин", 60 * 1000);
+    plotWindowBox->addItem("10 мин", 10 * 60 * 1000);
+    plotWindowBox->addItem("1 час", 60 * 60 * 1000);
+    plotWindowBox->addItem("6 часов", 6 * 60 * 60 * 1000);
+    windowControls->addWidget(new QLabel("Окно:"));
+    windowControls->addWidget(plotWindowBox);
+    // После перемотки записи история перезагружается на всё окно
+    replay->setHistoryWindow(plotWindowBox->currentData().toLongLong());
+    connect(plotWindowBox, &QComboBox::currentIndexChanged, this, [this]() {
+        replay->setHistoryWindow(plotWindowBox->currentData().toLongLong());
+    });
+    windowControls->addStretch();
+    plotLayout->addLayout(windowControls);
+
+    // По графику на канал, данные - столбцы и пирамиды активной истории
+    // (прямой эфир или воспроизводимая запись)
+    telemetry::forEachChannel([&](auto index, const auto &channel) {
+        constexpr std::size_t I = decltype(index)::value;
+        auto timestampsQuery = [this]() -> const std::vector<qint64> & {
+            return activeHistory().timestamps();
+        };
+        auto rangeQuery = [this](std::size_t first, std::size_t last) {
+            const auto range = activeHistory().range<I>(first, last);
+            return std::make_pair(static_cast<double>(range.first), static_cast<double>(range.second));
+        };
+        TelemetryPlot *plot = new TelemetryPlot(
+            QString("%1, %2").arg(channel.label).arg(channel.units), channel.precision,
+            timestampsQuery, rangeQuery);
+        plotLayout->addWidget(plot);
+        channelPlots[I] = plot;
+    });
+
+    plotGroup->setLayout(plotLayout);
+
+    QVBoxLayout *result = new QVBoxLayout();
+    result->addWidget(plotGroup);
+    return result;
+}
+
+void MainWindow::refreshPlots()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // В прямом эфире окно движется вместе с часами, при воспроизведении
+    // заканчивается на последнем показанном отсчёте
+    qint64 windowEnd = QDateTime::currentMSecsSinceEpoch();
+    if (replayMode && !replayHistory.empty()) {
+        windowEnd = replayHistory.timestamps().back();
+    }
+    const qint64 windowSpan = plotWindowBox->currentData().toLongLong();
+
+    for (TelemetryPlot *plot : channelPlots) {
+        plot->setWindow(windowEnd, windowSpan);
+        plot->update();
+    }
+}
+
+telemetry::History &MainWindow::activeHistory()
+{
+    return replayMode ? replayHistory : activeSession().history();
+}
+
 QVBoxLayout* MainWindow::createStatusPanel()
 {
     QGroupBox *statusGroup = new QGroupBox("Статус и журнал");
@@ -347,6 +716,14 @@ QVBoxLayout* MainWindow::createStatusPanel()
     connectionStatusLabel = new QLabel("Связь: <font color='green'>УСТАНОВЛЕНА</font>");
     connectionStatusLabel->setStyleSheet("font-weight: bold; font-size: 14px;");
     statusLayout->addWidget(connectionStatusLabel);
+
+    responsivenessLabel = new QLabel();
+    responsivenessLabel->setStyleSheet("color: #666;");
+    statusLayout->addWidget(responsivenessLabel);
+
+    sessionStatsLabel = new QLabel();
+    sessionStatsLabel->setStyleSheet("color: #666;");
+    statusLayout->addWidget(sessionStatsLabel);
     
     statusLayout->addWidget(new QLabel("Журнал:"));
     telemetryLog = new QTextEdit();
@@ -368,22 +745,66 @@ QVBoxLayout* MainWindow::createStatusPanel()
 
 void MainWindow::updateSensorData()
 {
-    distance = distDist(gen);
-    temperature = tempDist(gen);
-    humidity = humDist(gen);
-    
-    distanceSensorDisplay->display(QString::number(distance, 'f', 1));
-    temperatureDisplay->display(QString::number(temperature, 'f', 1));
-    humidityDisplay->display(humidity);
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // Телеметрия всех роботов идёт в их истории и буферы записи,
+    // на панель - последний отсчёт активного
+    for (const auto &session : sessions) {
+        if (session->pollTelemetry() && session.get() == &activeSession()) {
+            showTelemetry(session->latestSample());
+        }
+    }
+}
+
+void MainWindow::applyTelemetry(const telemetry::Sample &sample)
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    recordTelemetry(sample);
+    showTelemetry(sample);
+}
+
+void MainWindow::loadReplayHistory(const std::vector<telemetry::Sample> &samples)
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    replayHistory.clear();
+    for (const telemetry::Sample &sample : samples) {
+        replayHistory.append(sample);
+    }
+    if (!samples.empty()) {
+        showTelemetry(samples.back());
+    }
+}
+
+void MainWindow::recordTelemetry(const telemetry::Sample &sample)
+{
+    // Перемотка записи назад начинает историю заново
+    telemetry::History &history = activeHistory();
+    if (!history.empty() && sample.timestampMs < history.timestamps().back()) {
+        history.clear();
+    }
+    history.append(sample);
+}
+
+void MainWindow::showTelemetry(const telemetry::Sample &sample)
+{
+    currentSample = sample;
+
+    telemetry::forEachChannel([&](auto index, const auto &channel) {
+        constexpr std::size_t I = decltype(index)::value;
+        channelDisplays[I]->display(telemetry::formatValue(sample.get<I>(), channel));
+    });
     
-    QString timestamp = QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss");
+    QString timestamp = QDateTime::fromMSecsSinceEpoch(sample.timestampMs).toString("dd.MM.yyyy hh:mm:ss");
     timestampLabel->setText(timestamp);
     
-    QString logEntry = QString("[%1] Dist: %2cm, Temp: %3°C, Hum: %4%")
-                       .arg(timestamp)
-                       .arg(distance, 0, 'f', 1)
-                       .arg(temperature, 0, 'f', 1)
-                       .arg(humidity);
+    // В журнал - не чаще самого быстрого канала схемы, иначе при
+    // высокой частоте датчиков журнал забирает весь GUI-поток
+    const qint64 logPeriodMs = 1000 / telemetry::maxRateHz();
+    if (sample.timestampMs >= lastLogMs && sample.timestampMs - lastLogMs < logPeriodMs) {
+        return;
+    }
+    lastLogMs = sample.timestampMs;
+
+    QString logEntry = QString("[%1] %2").arg(timestamp).arg(telemetry::formatValues(sample));
     
     telemetryLog->append(logEntry);
     
@@ -402,84 +823,129 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
         QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
         if (keyEvent->isAutoRepeat()) return false;
 
+        UiWatchdog::Scope scope(Q_FUNC_INFO);
+        watchdog->keyPressed(keyEvent->timestamp());
+        bool handled = true;
         switch (keyEvent->key()) {
         case Qt::Key_W:
             moveForward();
-            return true;
+            break;
         case Qt::Key_S:
             moveBackward();
-            return true;
+            break;
         case Qt::Key_A:
             turnLeft();
-            return true;
+            break;
         case Qt::Key_D:
             turnRight();
-            return true;
+            break;
         case Qt::Key_Space:
             stopRobot();
-            return true;
+            break;
         default:
+            handled = false;
             break;
         }
+        watchdog->keyHandled();
+        if (handled) {
+            return true;
+        }
     }
     return QMainWindow::eventFilter(obj, event);
 }
 
 
+// Команда передана роботу: до этого момента и считается задержка
+// от нажатия клавиши. Неотправленная команда не теряется молча -
+// причина видна в строке состояния, а подтверждение вызывающий
+// показывает только при true
+bool MainWindow::dispatchCommand(const QString &text)
+{
+    RobotSession &session = activeSession();
+    QString error;
+    if (!session.sendCommand(text, &error)) {
+        const QString message = QString("%1: %2 - не отправлено: %3").arg(session.name()).arg(text).arg(error);
+        telemetryLog->append(QString("[CMD] %1").arg(message));
+        statusBar()->showMessage(message, kStatusMessageMs);
+        return false;
+    }
+    watchdog->commandDispatched();
+    telemetryLog->append(QString("[CMD] %1: %2").arg(session.name()).arg(text));
+    return true;
+}
+
 void MainWindow::moveForward()
 {
-    //TODO
-    telemetryLog->append("[CMD] ВПЕРЕД");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    dispatchCommand("forward");
 }
 
 
 void MainWindow::moveBackward()
 {
-    //TODO
-    telemetryLog->append("[CMD] НАЗАД");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    dispatchCommand("backward");
 }
 
 
 void MainWindow::turnLeft()
 {
-    //TODO
-    telemetryLog->append("[CMD] Поворот ВЛЕВО");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    dispatchCommand("left");
 }
 
 void MainWindow::turnRight()
 {
-    //TODO
-    telemetryLog->append("[CMD] Поворот ВПРАВО");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    dispatchCommand("right");
 }
 
 void MainWindow::stopRobot()
 {
-    //TODO
-    telemetryLog->append("[CMD] ОСТАНОВКА");
-    QMessageBox::information(this, "Команда", "Робот остановлен");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    if (dispatchCommand("stop")) {
+        statusBar()->showMessage("Робот остановлен", kStatusMessageMs);
+    }
 }
 
 void MainWindow::sendPacketCommand()
 {
-    QString commands = packetCommandEdit->toPlainText();
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // Каждая строка пакета - отдельная команда
+    QStringList commands;
+    for (const QString &line : packetCommandEdit->toPlainText().split('\n')) {
+        if (!line.trimmed().isEmpty()) {
+            commands << line.trimmed();
+        }
+    }
     if (commands.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Введите пакет команд");
+        statusBar()->showMessage("Введите пакет команд", kStatusMessageMs);
         return;
     }
-    
-    telemetryLog->append("[CMD] Отправка пакета команд:");
-    telemetryLog->append(commands);
-    QMessageBox::information(this, "Команда", "Пакет команд отправлен");
+
+    int sent = 0;
+    for (const QString &command : commands) {
+        sent += dispatchCommand(command) ? 1 : 0;
+    }
+    if (sent == commands.size()) {
+        statusBar()->showMessage(QString("Пакет команд отправлен: %1").arg(sent), kStatusMessageMs);
+    } else {
+        statusBar()->showMessage(QString("Пакет команд: отправлено %1, не отправлено %2")
+                                 .arg(sent).arg(commands.size() - sent), kStatusMessageMs);
+    }
 }
 
 void MainWindow::moveToObstacle()
 {
-    telemetryLog->append("[CMD] Движение до препятствия");
-    QMessageBox::information(this, "Команда", "Робот движется до препятствия");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    if (dispatchCommand("obstacle")) {
+        statusBar()->showMessage("Робот движется до препятствия", kStatusMessageMs);
+    }
 }
 
 void MainWindow::saveSnapshot()
 {
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
     QString filename = QString("snapshot_%1.png").arg(timestamp);
     
@@ -496,9 +962,7 @@ void MainWindow::saveSnapshot()
     if (!pixmap.isNull()) {                    
         pixmap.save(filepath);                  
         telemetryLog->append(QString("[SAVE] Кадр сохранен: %1").arg(filepath));
-        telemetryLog->append(QString("[DATA] Dist: %1cm, Temp: %2°C, GPS: %3, %4")
-                             .arg(distance, 0, 'f', 1)
-                             .arg(temperature, 0, 'f', 1));
+        telemetryLog->append(QString("[DATA] %1").arg(telemetry::formatValues(currentSample)));
         QMessageBox::information(this, "Сохранено", QString("Кадр сохранен:\n%1").arg(filepath));
     } else {
         QMessageBox::warning(this, "Ошибка", "Нет кадра для сохранения");
@@ -507,8 +971,87 @@ void MainWindow::saveSnapshot()
 
 
 
+void MainWindow::openReplay()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    QString filepath = QFileDialog::getOpenFileName(this, "Открыть запись", "videos",
+                                                    "Видеозаписи (*.mp4)");
+    if (filepath.isEmpty()) {
+        return;
+    }
+
+    // Режим включается до открытия: первый отсчёт записи приходит уже из open()
+    replayHistory.clear();
+    setReplayMode(true);
+
+    QString error;
+    if (!replay->open(filepath, &error)) {
+        // open() уже закрыл предыдущую запись - воспроизводить нечего
+        setReplayMode(false);
+        telemetryLog->append("[REPLAY] Возврат к прямому эфиру");
+        QMessageBox::warning(this, "Ошибка", error);
+        return;
+    }
+
+    replaySlider->setRange(0, static_cast<int>(replay->durationMs()));
+    replay->setSpeed(replaySpeedBox->currentData().toDouble());
+    telemetryLog->append(QString("[REPLAY] Открыта запись: %1 (%2)")
+                         .arg(filepath).arg(formatPosition(replay->durationMs())));
+    toggleReplayPlayback();
+}
+
+void MainWindow::toggleReplayPlayback()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    if (replay->isPlaying()) {
+        replay->pause();
+        btnReplayPlay->setText("▶");
+    } else {
+        replay->play();
+        btnReplayPlay->setText("❚❚");
+    }
+}
+
+void MainWindow::closeReplay()
+{
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    replay->close();
+    setReplayMode(false);
+    telemetryLog->append("[REPLAY] Возврат к прямому эфиру");
+}
+
+void MainWindow::setReplayMode(bool enabled)
+{
+    replayMode = enabled;
+
+    // В режиме воспроизведения живые данные на панели не выводятся
+    if (enabled) {
+        sensorUpdateTimer->stop();
+        for (const auto &session : sessions) {
+            session->pauseTelemetry();
+        }
+        videoTimer->stop();
+    } else {
+        for (const auto &session : sessions) {
+            session->resumeTelemetry();
+        }
+        sensorUpdateTimer->start();
+        videoTimer->start();
+        btnReplayPlay->setText("▶");
+        replaySlider->setValue(0);
+        replayPositionLabel->setText("--:-- / --:--");
+    }
+
+    btnReplayPlay->setEnabled(enabled);
+    replaySlider->setEnabled(enabled);
+    replaySpeedBox->setEnabled(enabled);
+    btnReplayLive->setEnabled(enabled);
+    btnSaveVideoStream->setEnabled(!enabled);
+}
+
 void MainWindow::toggleVideoQuality()
 {
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
     highQuality = !highQuality;
     if (highQuality) {
         videoQualityLabel->setText("Качество: <b>Высокое</b>");
@@ -523,12 +1066,15 @@ void MainWindow::toggleVideoQuality()
 
 void MainWindow::soundSignal()
 {
-    telemetryLog->append("[CMD] Звуковой сигнал");
-    QMessageBox::information(this, "Команда", "Звуковой сигнал отправлен");
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
+    if (dispatchCommand("sound")) {
+        statusBar()->showMessage("Звуковой сигнал отправлен", kStatusMessageMs);
+    }
 }
 
 void MainWindow::saveTelemetryToFile()
 {
+    UiWatchdog::Scope scope(Q_FUNC_INFO);
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
     QString filename = QString("telemetry_%1.txt").arg(timestamp);
     
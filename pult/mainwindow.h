@@ -19,17 +19,31 @@
 #include <QPixmap>
 #include <QImage>
 #include <QQueue>
+#include <QElapsedTimer>
+#include <QComboBox>
 #include <random>
+#include <memory>
+#include <array>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/videoio.hpp>
 
+#include "telemetryschema.h"
+#include "sessionreplay.h"
+#include "telemetryplot.h"
+#include "uiwatchdog.h"
+#include "robotsimulator.h"
+#include "robotsession.h"
+#include "workpool.h"
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    MainWindow(const SimulatorConfig &simulation, int robotCount,
+               const QStringList &robotAddresses, QWidget *parent = nullptr);
     ~MainWindow();
 
 private slots:
@@ -46,20 +60,41 @@ private slots:
     void toggleVideoQuality();
     void soundSignal();
     void saveVideoStream();
+    void openReplay();
+    void toggleReplayPlayback();
+    void closeReplay();
 
 private:
     void setupUI();
     QVBoxLayout* createControlPanel();
     QVBoxLayout* createTelemetryPanel();
+    QVBoxLayout* createPlotPanel();
     QVBoxLayout* createVideoPanel();
     QVBoxLayout* createStatusPanel();
     void saveTelemetryToFile();
-    void initCamera();
+    void initSessions();
+    RobotSession &activeSession();
+    void selectSession(int index);
+    void rebuildCameraControls();
+    void updateCameraStats();
+    void updateResponsiveness();
+    void showLinkStatus();
+    bool dispatchCommand(const QString &text);
+    void refreshPlots();
+    telemetry::History &activeHistory();
+    void showFrame(const cv::Mat &frame);
+    void showImage(const QImage &image);
+    void applyTelemetry(const telemetry::Sample &sample);
+    void loadReplayHistory(const std::vector<telemetry::Sample> &samples);
+    void recordTelemetry(const telemetry::Sample &sample);
+    void showTelemetry(const telemetry::Sample &sample);
+    void setReplayMode(bool enabled);
     
     // UI элементы
     QWidget *centralWidget;
     
     // Панель управления
+    QComboBox *robotBox;
     QPushButton *btnForward;
     QPushButton *btnBackward;
     QPushButton *btnLeft;
@@ -78,13 +113,31 @@ private:
     QPushButton *btnSaveVideoStream;
     QPushButton *btnToggleQuality;
     QLabel *videoQualityLabel;
+    QComboBox *mosaicLayoutBox;
+    QComboBox *exportSourceBox;
+    QLabel *cameraStatsLabel;
     bool highQuality;
+
+    // Воспроизведение записи
+    SessionReplay *replay;
+    QPushButton *btnOpenReplay;
+    QPushButton *btnReplayPlay;
+    QPushButton *btnReplayLive;
+    QSlider *replaySlider;
+    QComboBox *replaySpeedBox;
+    QLabel *replayPositionLabel;
+    bool replayMode;
     
     // Телеметрия
-    QLCDNumber *distanceSensorDisplay;
-    QLCDNumber *temperatureDisplay;
-    QLCDNumber *humidityDisplay;
+    std::array<QLCDNumber *, telemetry::kChannelCount> channelDisplays;
+
+    // Графики истории телеметрии
+    std::array<TelemetryPlot *, telemetry::kChannelCount> channelPlots;
+    QComboBox *plotWindowBox;
+    QTimer *plotTimer;
     QLabel *connectionStatusLabel;
+    QLabel *responsivenessLabel;
+    QLabel *sessionStatsLabel;
     QLabel *timestampLabel;
     
     // Лог телеметрии
@@ -96,27 +149,39 @@ private:
     QTimer *connectionTimer;
     QTimer *videoTimer;
     
-    // Камера и буфер видеокадров
-    cv::VideoCapture camera;
-    bool cameraAvailable;
-    QQueue<cv::Mat> videoFrameBuffer;
-    int maxFramesInBuffer;
+    QTimer *cameraStatsTimer;
+    QPixmap simulatedFrame;
+
+    // Сессии роботов и общий пул потоков для их видео и записи;
+    // пул объявлен раньше - сессии разрушаются первыми
+    WorkPool workPool;
+    std::vector<std::unique_ptr<RobotSession>> sessions;
+    int currentSession;
+    int robotCount;
+    // Адреса серверов роботов host:port, по порядку сессий
+    QStringList robotAddresses;
+    // Для загрузки пула за последний период
+    qint64 reportedPoolBusyNs;
+    qint64 reportedPoolUptimeNs;
     
     // Данные датчиков
-    double distance;
-    double temperature;
-    int humidity;
+    SimulatorConfig simulation;
+    telemetry::Sample currentSample;
+    telemetry::History replayHistory;
+    qint64 lastLogMs;
     bool isConnected;
+
+    // Сторож отзывчивости интерфейса
+    UiWatchdog *watchdog;
+
+    // Метрики запуска
+    QElapsedTimer startupClock;
+    bool firstFrameLogged;
     
     // Генератор случайных чисел
     std::random_device rd;
     std::mt19937 gen;
-    std::uniform_real_distribution<> distDist;
-    std::uniform_real_distribution<> tempDist;
-    std::uniform_int_distribution<> battDist;
-    std::uniform_int_distribution<> humDist;
     std::uniform_int_distribution<> signalDist;
-    std::uniform_real_distribution<> gpsDist;
 
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
@@ -0,0 +1,173 @@
+#include "mosaiccompositor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const cv::Scalar kBackground(26, 26, 26);
+const cv::Scalar kInsetBorder(100, 255, 100);
+// Размер врезки в режиме «картинка в картинке» относительно холста
+const int kInsetDivider = 4;
+const int kInsetMargin = 8;
+
+} // namespace
+
+MosaicCompositor::MosaicCompositor(cv::Size canvasSize)
+    : canvas(canvasSize, CV_8UC3, kBackground),
+      currentLayout(Layout::Grid),
+      primaryIndex(0),
+      tilesCount(-1)
+{
+}
+
+void MosaicCompositor::setLayout(Layout layout, int primary)
+{
+    currentLayout = layout;
+    primaryIndex = std::max(0, primary);
+    tilesCount = -1;
+    canvas.setTo(kBackground);
+}
+
+MosaicCompositor::Layout MosaicCompositor::layout() const
+{
+    return currentLayout;
+}
+
+int MosaicCompositor::primary() const
+{
+    return primaryIndex;
+}
+
+const cv::Mat &MosaicCompositor::compose(const std::vector<cv::Mat> &frames)
+{
+    const int count = static_cast<int>(frames.size());
+    updateTiles(count);
+    if (count == 0) {
+        return canvas;
+    }
+
+    if (currentLayout == Layout::PictureInPicture) {
+        // Основная камера на весь холст, врезки поверх неё
+        blit(frames[primaryIndex], tiles[primaryIndex]);
+        for (int i = 0; i < count; ++i) {
+            if (i != primaryIndex) {
+                blit(frames[i], tiles[i]);
+                cv::rectangle(canvas, tiles[i], kInsetBorder, 1);
+            }
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            blit(frames[i], tiles[i]);
+        }
+    }
+    return canvas;
+}
+
+void MosaicCompositor::updateTiles(int count)
+{
+    if (count == tilesCount) {
+        return;
+    }
+    tilesCount = count;
+    tiles.clear();
+    canvas.setTo(kBackground);
+    if (count == 0) {
+        return;
+    }
+
+    const int width = canvas.cols;
+    const int height = canvas.rows;
+
+    if (currentLayout == Layout::PictureInPicture) {
+        primaryIndex = std::min(primaryIndex, count - 1);
+        // Врезки идут рядами справа налево снизу вверх; если все не
+        // помещаются на холст, врезки уменьшаются, но не перекрываются
+        const int insets = count - 1;
+        int divider = kInsetDivider;
+        int insetWidth = 0;
+        int insetHeight = 0;
+        int perRow = 1;
+        while (true) {
+            insetWidth = std::max(1, width / divider);
+            insetHeight = std::max(1, height / divider);
+            perRow = std::max(1, (width - kInsetMargin) / (insetWidth + kInsetMargin));
+            const int rowsNeeded = (insets + perRow - 1) / perRow;
+            if (rowsNeeded * (insetHeight + kInsetMargin) + kInsetMargin <= height
+                || insetWidth == 1) {
+                break;
+            }
+            ++divider;
+        }
+        int slot = 0;
+        for (int i = 0; i < count; ++i) {
+            if (i == primaryIndex) {
+                tiles.emplace_back(0, 0, width, height);
+                continue;
+            }
+            const int column = slot % perRow;
+            const int row = slot / perRow;
+            const int x = std::max(0, width - (column + 1) * (insetWidth + kInsetMargin));
+            const int y = std::max(0, height - (row + 1) * (insetHeight + kInsetMargin));
+            tiles.emplace_back(x, y, insetWidth, insetHeight);
+            ++slot;
+        }
+        return;
+    }
+
+    const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const int rows = (count + columns - 1) / columns;
+    const int tileWidth = width / columns;
+    const int tileHeight = height / rows;
+    for (int i = 0; i < count; ++i) {
+        tiles.emplace_back((i % columns) * tileWidth, (i / columns) * tileHeight,
+                           tileWidth, tileHeight);
+    }
+}
+
+void MosaicCompositor::blit(const cv::Mat &frame, const cv::Rect &tile)
+{
+    cv::Mat target = canvas(tile);
+    if (frame.empty()) {
+        target.setTo(kBackground);
+        cv::putText(target, "NO SIGNAL", cv::Point(tile.width / 2 - 45, tile.height / 2),
+                    cv::FONT_HERSHEY_SIMPLEX, 0.6, kInsetBorder, 1, cv::LINE_AA);
+        return;
+    }
+
+    // resize пишет в ROI холста, только если тип совпадает с CV_8UC3;
+    // иначе он молча перевыделяет dst и плитка не рисуется
+    cv::Mat source = frame;
+    if (source.depth() == CV_16U) {
+        source.convertTo(source, CV_8U, 1.0 / 256);
+    } else if (source.depth() == CV_32F || source.depth() == CV_64F) {
+        source.convertTo(source, CV_8U, 255.0);
+    } else if (source.depth() != CV_8U) {
+        source.convertTo(source, CV_8U);
+    }
+    if (source.channels() == 1) {
+        cv::cvtColor(source, source, cv::COLOR_GRAY2BGR);
+    } else if (source.channels() == 4) {
+        cv::cvtColor(source, source, cv::COLOR_BGRA2BGR);
+    } else if (source.channels() != 3) {
+        target.setTo(kBackground);
+        cv::putText(target, "BAD FORMAT", cv::Point(tile.width / 2 - 50, tile.height / 2),
+                    cv::FONT_HERSHEY_SIMPLEX, 0.6, kInsetBorder, 1, cv::LINE_AA);
+        return;
+    }
+
+    // Вписываем кадр в плитку с сохранением пропорций
+    const double scale = std::min(static_cast<double>(tile.width) / source.cols,
+                                  static_cast<double>(tile.height) / source.rows);
+    const cv::Size fitted(std::max(1, static_cast<int>(source.cols * scale)),
+                          std::max(1, static_cast<int>(source.rows * scale)));
+    const cv::Rect fittedRect((tile.width - fitted.width) / 2, (tile.height - fitted.height) / 2,
+                              fitted.width, fitted.height);
+    if (fitted != tile.size()) {
+        target.setTo(kBackground);
+    }
+
+    // dst - заголовок на ROI холста нужного размера, resize пишет прямо в него
+    cv::Mat destination = target(fittedRect);
+    const int interpolation = scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR;
+    cv::resize(source, destination, fitted, 0, 0, interpolation);
+}
@@ -0,0 +1,38 @@
+#ifndef MOSAICCOMPOSITOR_H
+#define MOSAICCOMPOSITOR_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Сборка кадров нескольких камер в один заранее выделенный холст.
+// Масштабирование идёт cv::resize прямо в ROI холста - без промежуточных
+// копий. Плитки рисуются последовательно: compose() вызывается из задачи
+// WorkPool, и параллелизм даёт пул (кадры разных роботов), а не
+// отдельный пул потоков OpenCV поверх него.
+class MosaicCompositor
+{
+public:
+    enum class Layout { Grid, PictureInPicture };
+
+    explicit MosaicCompositor(cv::Size canvasSize);
+
+    void setLayout(Layout layout, int primary = 0);
+    Layout layout() const;
+    int primary() const;
+
+    // Пустой кадр в frames рисуется как плитка «нет сигнала»
+    const cv::Mat &compose(const std::vector<cv::Mat> &frames);
+
+private:
+    void updateTiles(int count);
+    void blit(const cv::Mat &frame, const cv::Rect &tile);
+
+    cv::Mat canvas;
+    Layout currentLayout;
+    int primaryIndex;
+    std::vector<cv::Rect> tiles;
+    int tilesCount;
+};
+
+#endif // MOSAICCOMPOSITOR_H
@@ -0,0 +1,426 @@
+#include "robotsession.h"
+#include "sessionreplay.h"
+#include <QDateTime>
+#include <QDir>
+#include <QMetaObject>
+#include <algorithm>
+
+namespace {
+
+// Кадров мозаики в буфере записи (~30 секунд при 30 FPS) - если
+// раньше не кончится объём буфера
+const int kMaxRecordFrames = 900;
+// Сколько телеметрии держать для записи, пока нет видео (~30 секунд)
+const qint64 kTelemetryBufferMs = 30000;
+// История для графиков - на самое длинное окно (6 часов)
+const qint64 kHistoryRetentionMs = 6 * 60 * 60 * 1000LL;
+// Холст мозаики
+const cv::Size kMosaicSize(640, 360);
+// Параметры видеозаписи
+const double kRecordFps = 30.0;
+const cv::Size kRecordSize(1280, 720);
+
+} // namespace
+
+RobotSession::RobotSession(int id, const QString &name, std::unique_ptr<TelemetrySource> source,
+                           std::vector<std::unique_ptr<CaptureSource>> cameras, std::size_t recordBytes,
+                           WorkPool &pool, QObject *parent)
+    : QObject(parent),
+      sessionId(id),
+      sessionName(name),
+      pool(pool),
+      source(std::move(source)),
+      haveSample(false),
+      link(nullptr),
+      commandCount(0),
+      commandsFailed(0),
+      sources(std::move(cameras)),
+      compositor(kMosaicSize),
+      appliedLayout(0),
+      requestedLayout(0),
+      frameTaskRunning(false),
+      recording(false),
+      framesComposed(0),
+      framesSkipped(0),
+      recordBytesLimit(recordBytes),
+      recordBytesUsed(0),
+      reportedFrames(0),
+      reportedAtNs(pool.uptimeNs())
+{
+    sourceStates.assign(sources.size(), CaptureSource::State::Probing);
+    sourceFrames.resize(sources.size());
+    this->source->start();
+}
+
+RobotSession::~RobotSession()
+{
+    // Камеры сначала: поток захвата ставит задачи в пул за счёт сессии.
+    // Задачи пула держат this - дожидаемся их до разрушения полей
+    for (auto &camera : sources) {
+        camera->stop();
+    }
+    pool.wait(resources);
+}
+
+int RobotSession::id() const
+{
+    return sessionId;
+}
+
+QString RobotSession::name() const
+{
+    return sessionName;
+}
+
+void RobotSession::pauseTelemetry()
+{
+    source->stop();
+}
+
+void RobotSession::resumeTelemetry()
+{
+    source->start();
+}
+
+bool RobotSession::pollTelemetry()
+{
+    polledSamples.clear();
+    source->poll(polledSamples);
+    if (polledSamples.empty()) {
+        return false;
+    }
+
+    for (const telemetry::Sample &sample : polledSamples) {
+        telemetryBuffer.enqueue(sample);
+        telemetryHistory.append(sample);
+    }
+    latest = polledSamples.back();
+    haveSample = true;
+    telemetryHistory.dropBefore(latest.timestampMs - kHistoryRetentionMs);
+
+    // Телеметрию храним столько же, сколько кадров в буфере видео
+    qint64 oldestFrame = -1;
+    {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        if (!recordFrameTimes.isEmpty()) {
+            oldestFrame = recordFrameTimes.head();
+        }
+    }
+    const qint64 keepFrom = oldestFrame >= 0 ? oldestFrame : latest.timestampMs - kTelemetryBufferMs;
+    while (!telemetryBuffer.isEmpty() && telemetryBuffer.head().timestampMs < keepFrom) {
+        telemetryBuffer.dequeue();
+    }
+    return true;
+}
+
+const telemetry::Sample &RobotSession::latestSample() const
+{
+    return latest;
+}
+
+bool RobotSession::hasTelemetry() const
+{
+    return haveSample;
+}
+
+telemetry::History &RobotSession::history()
+{
+    return telemetryHistory;
+}
+
+void RobotSession::startCameras(int probeTimeoutMs)
+{
+    for (auto &camera : sources) {
+        camera->start(probeTimeoutMs, pool, resources);
+    }
+}
+
+const std::vector<std::unique_ptr<CaptureSource>> &RobotSession::cameras() const
+{
+    return sources;
+}
+
+void RobotSession::setMosaicLayout(int index)
+{
+    // Компоновщик принадлежит задаче кадра, раскладка меняется там же
+    requestedLayout = index;
+}
+
+int RobotSession::mosaicLayout() const
+{
+    return requestedLayout.load();
+}
+
+bool RobotSession::captureFrame(bool display, bool lowQuality, const QSize &displaySize)
+{
+    const bool anyRunning = std::any_of(sources.cbegin(), sources.cend(), [](const auto &camera) {
+        return camera->state() == CaptureSource::State::Running;
+    });
+    if (!anyRunning) {
+        return false;
+    }
+    // Предыдущий кадр ещё собирается - пул перегружен, этот пропускаем
+    if (frameTaskRunning.exchange(true)) {
+        ++framesSkipped;
+        return true;
+    }
+    pool.submit(resources, [this, display, lowQuality, displaySize]() {
+        try {
+            composeFrame(display, lowQuality, displaySize);
+        } catch (...) {
+            frameTaskRunning = false;
+            throw;
+        }
+        frameTaskRunning = false;
+    });
+    return true;
+}
+
+void RobotSession::composeFrame(bool display, bool lowQuality, const QSize &displaySize)
+{
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i]->state() != CaptureSource::State::Running
+            || !sources[i]->latestFrame(sourceFrames[i])) {
+            sourceFrames[i].release();
+        }
+    }
+
+    const int layout = requestedLayout.load();
+    if (layout != appliedLayout) {
+        if (layout <= 0) {
+            compositor.setLayout(MosaicCompositor::Layout::Grid);
+        } else {
+            compositor.setLayout(MosaicCompositor::Layout::PictureInPicture, layout - 1);
+        }
+        appliedLayout = layout;
+    }
+
+    const cv::Mat &mosaic = compositor.compose(sourceFrames);
+    cv::Mat outFrame = mosaic;
+    if (lowQuality) {
+        cv::resize(mosaic, outFrame, cv::Size(128, 72));
+    }
+
+    // В буфер записи - тот же кадр, в BGR для VideoWriter
+    {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        recordFrames.enqueue(outFrame.clone());
+        recordFrameTimes.enqueue(QDateTime::currentMSecsSinceEpoch());
+        recordBytesUsed += outFrame.total() * outFrame.elemSize();
+        while (recordFrames.size() > 1
+               && (recordFrames.size() > kMaxRecordFrames || recordBytesUsed > recordBytesLimit)) {
+            const cv::Mat oldest = recordFrames.dequeue();
+            recordBytesUsed -= oldest.total() * oldest.elemSize();
+            recordFrameTimes.dequeue();
+        }
+    }
+    ++framesComposed;
+
+    if (display) {
+        // QImage можно готовить вне GUI-потока, QPixmap - нельзя
+        cv::Mat rgbFrame;
+        cv::cvtColor(outFrame, rgbFrame, cv::COLOR_BGR2RGB);
+        const QImage view(rgbFrame.data, rgbFrame.cols, rgbFrame.rows,
+                          static_cast<int>(rgbFrame.step), QImage::Format_RGB888);
+        QImage image = view.scaled(displaySize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        if (image.constBits() == view.constBits()) {
+            // Размер совпал - scaled() вернул ту же память rgbFrame
+            image = view.copy();
+        }
+        QMetaObject::invokeMethod(this, [this, image]() { emit frameReady(image); }, Qt::QueuedConnection);
+    }
+}
+
+QString RobotSession::cameraStatus(QStringList &events)
+{
+    QStringList stats;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const CaptureSource &camera = *sources[i];
+        const CaptureSource::State state = camera.state();
+
+        if (state != sourceStates[i]) {
+            if (state == CaptureSource::State::Running && camera.openedLate()) {
+                events << QString("%1: подключена с опозданием, открылась через %2 мс")
+                          .arg(camera.name()).arg(camera.openTimeMs());
+            } else if (state == CaptureSource::State::Running) {
+                events << QString("%1: подключена за %2 мс").arg(camera.name()).arg(camera.openTimeMs());
+            } else if (state == CaptureSource::State::Unavailable) {
+                events << QString("%1: нет сигнала").arg(camera.name());
+            }
+            sourceStates[i] = state;
+        }
+
+        if (state == CaptureSource::State::Running) {
+            // Задержка = время чтения кадра драйвером + возраст кадра на экране
+            const qint64 frameTime = camera.lastFrameTimeMs();
+            stats << QString("%1: %2 FPS, %3 мс")
+                     .arg(camera.name())
+                     .arg(camera.fps(), 0, 'f', 1)
+                     .arg(camera.readLatencyMs() + std::max<qint64>(0, now - frameTime), 0, 'f', 0);
+        } else if (state == CaptureSource::State::Probing) {
+            stats << QString("%1: поиск...").arg(camera.name());
+        } else {
+            stats << QString("%1: нет сигнала").arg(camera.name());
+        }
+    }
+    return stats.join("  |  ");
+}
+
+bool RobotSession::saveRecording(int sourceIndex, QString *error)
+{
+    if (recording.exchange(true)) {
+        if (error) *error = "Предыдущая запись ещё сохраняется";
+        return false;
+    }
+
+    std::vector<cv::Mat> frames;
+    std::vector<qint64> frameTimes;
+    if (sourceIndex <= 0) {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        while (!recordFrames.isEmpty()) {
+            frames.push_back(recordFrames.dequeue());
+            frameTimes.push_back(recordFrameTimes.dequeue());
+        }
+        recordBytesUsed = 0;
+    } else {
+        sources[sourceIndex - 1]->takeRecording(frames, frameTimes);
+    }
+    if (frames.empty()) {
+        recording = false;
+        if (error) *error = "Нет кадров для сохранения";
+        return false;
+    }
+
+    // Телеметрия копируется: она общая для всех источников сессии
+    // и очищается только вместе с буфером мозаики
+    std::vector<telemetry::Sample> samples(telemetryBuffer.cbegin(), telemetryBuffer.cend());
+    if (sourceIndex <= 0) {
+        telemetryBuffer.clear();
+    }
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    const QString path = QString("videos/video_%1_robot%2.mp4").arg(timestamp).arg(sessionId);
+    pool.submit(resources, [this, path, frames = std::move(frames), frameTimes = std::move(frameTimes),
+                            samples = std::move(samples)]() mutable {
+        QString failure;
+        int written = 0;
+        try {
+            written = writeRecording(path, frames, frameTimes, samples, &failure);
+        } catch (const cv::Exception &exception) {
+            failure = QString::fromStdString(exception.what());
+        }
+        recording = false;
+        QMetaObject::invokeMethod(this, [this, path, written, failure]() {
+            emit recordingFinished(path, written, failure);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+int RobotSession::writeRecording(const QString &path, std::vector<cv::Mat> &frames,
+                                 const std::vector<qint64> &frameTimes,
+                                 const std::vector<telemetry::Sample> &samples, QString *error)
+{
+    // Создаём папку videos если её нет
+    QDir dir;
+    if (!dir.exists("videos")) {
+        dir.mkdir("videos");
+    }
+
+    cv::VideoWriter videoWriter(path.toStdString(), cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+                                kRecordFps, kRecordSize, true);
+    if (!videoWriter.isOpened()) {
+        *error = "Не удалось открыть файл для записи";
+        return 0;
+    }
+
+    int frameCount = 0;
+    for (cv::Mat &frame : frames) {
+        if (frame.cols != kRecordSize.width || frame.rows != kRecordSize.height) {
+            cv::resize(frame, frame, kRecordSize);
+        }
+        videoWriter.write(frame);
+        frameCount++;
+    }
+    videoWriter.release();
+
+    // Рядом с видео - сжатый файл телеметрии с метками времени кадров
+    if (!SessionReplay::writeTelemetry(SessionReplay::telemetryPathFor(path), frameTimes, samples)) {
+        *error = "Не удалось записать файл телеметрии";
+    }
+    return frameCount;
+}
+
+void RobotSession::connectRobot(const QString &host, quint16 port)
+{
+    link = new CommandLink(host, port, this);
+    connect(link, &CommandLink::replyReceived, this, &RobotSession::commandReply);
+    connect(link, &CommandLink::connectionChanged, this, &RobotSession::linkChanged);
+}
+
+const CommandLink *RobotSession::commandLink() const
+{
+    return link;
+}
+
+bool RobotSession::sendCommand(const QString &command, QString *error)
+{
+    if (!link) {
+        ++commandsFailed;
+        if (error) *error = "нет канала связи с роботом (ключ --robot)";
+        return false;
+    }
+    if (!link->send(command, error)) {
+        ++commandsFailed;
+        return false;
+    }
+    ++commandCount;
+    return true;
+}
+
+const ResourceAccount &RobotSession::account() const
+{
+    return resources;
+}
+
+QString RobotSession::resourceSummary()
+{
+    const ResourceAccount::Snapshot now = resources.snapshot();
+    const quint64 frames = framesComposed.load();
+    const qint64 nowNs = pool.uptimeNs();
+    const double seconds = std::max<qint64>(1, nowNs - reportedAtNs) / 1e9;
+
+    const quint64 tasks = now.tasks - reported.tasks;
+    // Доля одного ядра, занятая задачами сессии
+    const double corePercent = (now.busyNs - reported.busyNs) / 1e7 / seconds;
+    const double waitMs = tasks ? (now.waitNs - reported.waitNs) / 1e6 / tasks : 0.0;
+    const QString summary = QString("%1: %2% ядра, задач %3/с, ожидание %4 мс, кадров %5/с, пропущено %6")
+                                .arg(sessionName)
+                                .arg(corePercent, 0, 'f', 1)
+                                .arg(tasks / seconds, 0, 'f', 0)
+                                .arg(waitMs, 0, 'f', 2)
+                                .arg((frames - reportedFrames) / seconds, 0, 'f', 0)
+                                .arg(framesSkipped.load());
+
+    reported = now;
+    reportedFrames = frames;
+    reportedAtNs = nowNs;
+    return summary;
+}
+
+QString RobotSession::resourceTotals() const
+{
+    const ResourceAccount::Snapshot total = resources.snapshot();
+    return QString("%1: задач %2 (перехвачено %3), CPU %4 мс, среднее ожидание %5 мс, "
+                   "кадров %6, пропущено %7, команд %8 (не отправлено %9)")
+        .arg(sessionName)
+        .arg(total.tasks)
+        .arg(total.stolen)
+        .arg(total.busyNs / 1000000)
+        .arg(total.tasks ? total.waitNs / 1e6 / total.tasks : 0.0, 0, 'f', 2)
+        .arg(framesComposed.load())
+        .arg(framesSkipped.load())
+        .arg(commandCount)
+        .arg(commandsFailed);
+}
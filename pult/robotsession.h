@@ -0,0 +1,134 @@
+#ifndef ROBOTSESSION_H
+#define ROBOTSESSION_H
+
+#include <QObject>
+#include <QImage>
+#include <QQueue>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "capturesource.h"
+#include "commandlink.h"
+#include "mosaiccompositor.h"
+#include "telemetryschema.h"
+#include "telemetrysource.h"
+#include "workpool.h"
+
+// Сессия одного робота: его телеметрия, камеры, история и буферы
+// записи. Телеметрия опрашивается в GUI-потоке (дёшево), а декодирование
+// кадров камер, сборка мозаики, подготовка кадра для экрана и запись
+// файлов идут задачами общего WorkPool; время этих задач копится
+// в account() сессии.
+// Буфер мозаики для записи ограничен объёмом recordBytes.
+class RobotSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    RobotSession(int id, const QString &name, std::unique_ptr<TelemetrySource> source,
+                 std::vector<std::unique_ptr<CaptureSource>> cameras, std::size_t recordBytes,
+                 WorkPool &pool, QObject *parent = nullptr);
+    ~RobotSession();
+
+    int id() const;
+    QString name() const;
+
+    // Останавливает и возобновляет поток телеметрии (режим воспроизведения)
+    void pauseTelemetry();
+    void resumeTelemetry();
+    // Забирает новые отсчёты в историю и буфер записи; false - новых нет
+    bool pollTelemetry();
+    const telemetry::Sample &latestSample() const;
+    bool hasTelemetry() const;
+    telemetry::History &history();
+
+    // Запускает камеры; их декодирование идёт в пуле за счёт сессии
+    void startCameras(int probeTimeoutMs);
+    const std::vector<std::unique_ptr<CaptureSource>> &cameras() const;
+    // 0 - сетка, иначе «картинка в картинке» с камерой index - 1
+    void setMosaicLayout(int index);
+    int mosaicLayout() const;
+    // Ставит в пул сборку очередного кадра; если кадр нужен на экране,
+    // результат придёт сигналом frameReady. false - ни одна камера не работает
+    bool captureFrame(bool display, bool lowQuality, const QSize &displaySize);
+    // Строка состояния камер; смены состояний дописываются в events
+    QString cameraStatus(QStringList &events);
+
+    // Забирает буфер (0 - мозаика, иначе камера sourceIndex - 1) и пишет
+    // его в пуле; окончание - сигнал recordingFinished
+    bool saveRecording(int sourceIndex, QString *error);
+
+    // Канал команд к серверу робота; без него команды не отправляются
+    void connectRobot(const QString &host, quint16 port);
+    const CommandLink *commandLink() const;
+    // false и *error - команда не ушла (нет канала или связи)
+    bool sendCommand(const QString &command, QString *error);
+
+    const ResourceAccount &account() const;
+    // Расход ресурсов с прошлого вызова
+    QString resourceSummary();
+    // Итог за всё время сессии
+    QString resourceTotals() const;
+
+signals:
+    void frameReady(const QImage &image);
+    void recordingFinished(const QString &path, int frameCount, const QString &error);
+    void commandReply(const QString &reply);
+    void linkChanged(bool connected);
+
+private:
+    void composeFrame(bool display, bool lowQuality, const QSize &displaySize);
+    static int writeRecording(const QString &path, std::vector<cv::Mat> &frames,
+                              const std::vector<qint64> &frameTimes,
+                              const std::vector<telemetry::Sample> &samples, QString *error);
+
+    const int sessionId;
+    const QString sessionName;
+    WorkPool &pool;
+    ResourceAccount resources;
+
+    // Телеметрия (GUI-поток)
+    std::unique_ptr<TelemetrySource> source;
+    std::vector<telemetry::Sample> polledSamples;
+    telemetry::Sample latest;
+    bool haveSample;
+    telemetry::History telemetryHistory;
+    QQueue<telemetry::Sample> telemetryBuffer;
+    CommandLink *link;
+    quint64 commandCount;
+    quint64 commandsFailed;
+
+    // Видео: камеры опрашиваются задачей пула, одновременно - не больше одной
+    std::vector<std::unique_ptr<CaptureSource>> sources;
+    std::vector<CaptureSource::State> sourceStates;
+    std::vector<cv::Mat> sourceFrames;
+    MosaicCompositor compositor;
+    int appliedLayout;
+    std::atomic<int> requestedLayout;
+    std::atomic<bool> frameTaskRunning;
+    std::atomic<bool> recording;
+    std::atomic<quint64> framesComposed;
+    std::atomic<quint64> framesSkipped;
+
+    // Буфер мозаики для записи (пишется из пула, забирается GUI-потоком)
+    mutable std::mutex recordMutex;
+    QQueue<cv::Mat> recordFrames;
+    QQueue<qint64> recordFrameTimes;
+    const std::size_t recordBytesLimit;
+    std::size_t recordBytesUsed;
+
+    // Для resourceSummary()
+    ResourceAccount::Snapshot reported;
+    quint64 reportedFrames;
+    qint64 reportedAtNs;
+};
+
+#endif // ROBOTSESSION_H
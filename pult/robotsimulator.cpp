@@ -0,0 +1,362 @@
+#include "robotsimulator.h"
+#include <QDateTime>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+// Время корреляции медленных изменений и амплитуда шума измерения
+// (доля диапазона канала)
+const double kDriftTimeS = 20.0;
+const double kNoiseFraction = 0.005;
+// Полный цикл разряда батареи
+const double kBatteryCycleS = 600.0;
+// Длительности сбоев, секунды
+const double kDropoutMinS = 0.2;
+const double kDropoutMaxS = 2.0;
+const double kStuckMinS = 1.0;
+const double kStuckMaxS = 5.0;
+const double kTwoPi = 6.283185307179586;
+
+template<typename T>
+T quantize(double value, const telemetry::Channel<T> &channel)
+{
+    if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(std::lround(value));
+    } else {
+        const double scale = std::pow(10.0, channel.precision);
+        return std::round(value * scale) / scale;
+    }
+}
+
+// FNV-1a: контрольная сумма прогона для --sim-check
+quint64 fnv1a(quint64 hash, const void *data, std::size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+PortableRandom::PortableRandom(quint64 seed)
+    : engine(seed),
+      haveSpare(false),
+      spare(0.0)
+{
+}
+
+double PortableRandom::uniform()
+{
+    // Старшие 53 бита - мантисса double
+    return static_cast<double>(engine() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int PortableRandom::uniformInt(int low, int high)
+{
+    const quint64 span = static_cast<quint64>(static_cast<qint64>(high) - low) + 1;
+    return low + static_cast<int>(engine() % span);
+}
+
+double PortableRandom::normal()
+{
+    if (haveSpare) {
+        haveSpare = false;
+        return spare;
+    }
+    // 1 - uniform() в (0, 1]: логарифм всегда конечен
+    const double radius = std::sqrt(-2.0 * std::log(1.0 - uniform()));
+    const double angle = kTwoPi * uniform();
+    spare = radius * std::sin(angle);
+    haveSpare = true;
+    return radius * std::cos(angle);
+}
+
+SensorSimulator::SensorSimulator(const SimulatorConfig &config)
+    : config(config),
+      random(config.seed),
+      faultProbability(config.faultsPerMinute / (60.0 * config.sensorRateHz)),
+      baseMs(QDateTime::currentMSecsSinceEpoch()),
+      startIndex(0),
+      sampleIndex(0),
+      updatedAt{},
+      dropoutUntil(0),
+      stuckUntil{},
+      spikeChannel(-1),
+      faults(0)
+{
+    // Процессы стартуют из середины диапазона
+    telemetry::forEachChannel([this](auto index, const auto &channel) {
+        constexpr std::size_t I = decltype(index)::value;
+        levels[I] = (static_cast<double>(channel.simMin) + channel.simMax) / 2.0;
+        previous.get<I>() = quantize(levels[I], channel);
+    });
+}
+
+QString SensorSimulator::name() const
+{
+    return QString("Имитатор (seed %1, %2 Гц)").arg(config.seed).arg(config.sensorRateHz);
+}
+
+void SensorSimulator::start()
+{
+    // После паузы метки времени продолжаются от текущего момента
+    startIndex = sampleIndex;
+    baseMs = QDateTime::currentMSecsSinceEpoch()
+             - static_cast<qint64>(startIndex * 1000 / config.sensorRateHz);
+    clock.start();
+}
+
+void SensorSimulator::stop()
+{
+    clock.invalidate();
+}
+
+void SensorSimulator::poll(std::vector<telemetry::Sample> &out)
+{
+    if (!clock.isValid()) {
+        return;
+    }
+    const quint64 due = startIndex + static_cast<quint64>(clock.elapsed()) * config.sensorRateHz / 1000 + 1;
+    telemetry::Sample sample;
+    while (sampleIndex < due) {
+        if (next(sample)) {
+            out.push_back(sample);
+        }
+    }
+}
+
+void SensorSimulator::generate(std::size_t count, std::vector<telemetry::Sample> &out)
+{
+    out.reserve(out.size() + count);
+    telemetry::Sample sample;
+    while (count > 0) {
+        if (next(sample)) {
+            out.push_back(sample);
+            --count;
+        }
+    }
+}
+
+qint64 SensorSimulator::timestampOf(quint64 index) const
+{
+    return baseMs + static_cast<qint64>(index * 1000 / config.sensorRateHz);
+}
+
+bool SensorSimulator::updatesAt(quint64 index, int rateHz) const
+{
+    // Отсчёт открывает новый период датчика; датчик быстрее потока
+    // обновляется в каждом отсчёте
+    const quint64 rate = static_cast<quint64>(rateHz);
+    const quint64 sampleRate = static_cast<quint64>(config.sensorRateHz);
+    return index == 0 || rate >= sampleRate || index * rate / sampleRate != (index - 1) * rate / sampleRate;
+}
+
+bool SensorSimulator::next(telemetry::Sample &sample)
+{
+    const quint64 index = sampleIndex++;
+    if (faultProbability > 0.0 && random.uniform() < faultProbability) {
+        startFault(index);
+    }
+
+    const double sampleDt = 1.0 / config.sensorRateHz;
+
+    sample = previous;
+    sample.timestampMs = timestampOf(index);
+    telemetry::forEachChannel([&](auto channelIndex, const auto &channel) {
+        constexpr std::size_t I = decltype(channelIndex)::value;
+        if (!updatesAt(index, channel.rateHz)) {
+            return;
+        }
+        // Шаг процесса - время с прошлого обновления этого датчика
+        const double dt = (index - updatedAt[I]) * sampleDt;
+        updatedAt[I] = index;
+        const double decay = std::exp(-dt / kDriftTimeS);
+        const double diffusion = std::sqrt(1.0 - decay * decay);
+
+        const double low = channel.simMin;
+        const double high = channel.simMax;
+        const double range = high - low;
+        double &level = levels[I];
+
+        if constexpr (I == telemetry::Battery) {
+            const double phase = std::fmod(index * sampleDt / kBatteryCycleS, 1.0);
+            level = high - range * phase;
+        } else {
+            // Дискретный процесс Орнштейна-Уленбека: точен при любом шаге,
+            // стационарное отклонение - шестая часть диапазона
+            const double mean = (low + high) / 2.0;
+            level = mean + decay * (level - mean) + diffusion * (range / 6.0) * random.normal();
+            level = std::clamp(level, low, high);
+        }
+
+        if (index < stuckUntil[I]) {
+            return;
+        }
+        double measured = level;
+        if (static_cast<int>(I) == spikeChannel) {
+            // Выброс - в ближайшем обновлении своего датчика
+            measured = high + range;
+            spikeChannel = -1;
+        } else if constexpr (I != telemetry::Battery) {
+            measured = std::clamp(level + kNoiseFraction * range * random.normal(), low, high);
+        }
+        sample.get<I>() = quantize(measured, channel);
+    });
+    previous = sample;
+
+    return index >= dropoutUntil;
+}
+
+void SensorSimulator::startFault(quint64 index)
+{
+    ++faults;
+    const double rate = config.sensorRateHz;
+    const int channel = random.uniformInt(0, telemetry::kChannelCount - 1);
+    switch (static_cast<Fault>(random.uniformInt(0, 2))) {
+    case Fault::Dropout:
+        dropoutUntil = index + static_cast<quint64>(rate * (kDropoutMinS + (kDropoutMaxS - kDropoutMinS) * random.uniform()));
+        break;
+    case Fault::Stuck:
+        stuckUntil[channel] = index + static_cast<quint64>(rate * (kStuckMinS + (kStuckMaxS - kStuckMinS) * random.uniform()));
+        break;
+    case Fault::Spike:
+        spikeChannel = channel;
+        break;
+    }
+}
+
+SyntheticCamera::SyntheticCamera(quint64 seed, cv::Size size, int fps)
+    : seed(seed),
+      size(size),
+      fps(std::max(1, fps)),
+      frameIndex(0)
+{
+    PortableRandom random(seed);
+    auto pick = [&random](int low, int high) { return random.uniformInt(low, high); };
+    origin = cv::Point(pick(0, std::max(0, size.width - 1)), pick(0, std::max(0, size.height - 1)));
+    velocity = cv::Point(pick(2, 8), pick(1, 6));
+    color = cv::Scalar(pick(64, 255), pick(64, 255), pick(64, 255));
+}
+
+bool SyntheticCamera::open()
+{
+    startTime = std::chrono::steady_clock::now();
+    frameIndex = 0;
+    return size.width > 0 && size.height > 0;
+}
+
+bool SyntheticCamera::grab()
+{
+    // Кадры выдаются по расписанию, как с настоящей камеры
+    std::this_thread::sleep_until(startTime + std::chrono::microseconds(frameIndex * 1000000 / fps));
+    return true;
+}
+
+bool SyntheticCamera::retrieve(cv::Mat &frame)
+{
+    render(frame);
+    ++frameIndex;
+    return true;
+}
+
+void SyntheticCamera::render(cv::Mat &frame) const
+{
+    frame.create(size, CV_8UC3);
+
+    // Вертикальный градиент, сдвигающийся на строку за кадр
+    for (int y = 0; y < size.height; ++y) {
+        const int shade = static_cast<int>((y + frameIndex) % 256);
+        frame.row(y).setTo(cv::Scalar(shade / 2, shade / 4, 64));
+    }
+
+    // Прямоугольник отражается от краёв кадра
+    const cv::Size box(std::max(8, size.width / 8), std::max(8, size.height / 8));
+    auto bounce = [](qint64 position, int span) {
+        if (span <= 0) {
+            return 0;
+        }
+        const qint64 period = 2 * static_cast<qint64>(span);
+        const qint64 phase = position % period;
+        return static_cast<int>(phase < span ? phase : period - phase);
+    };
+    const cv::Point corner(bounce(origin.x + velocity.x * frameIndex, size.width - box.width),
+                           bounce(origin.y + velocity.y * frameIndex, size.height - box.height));
+    cv::rectangle(frame, cv::Rect(corner, box), color, cv::FILLED);
+
+    cv::putText(frame, cv::format("SIM %llu  #%lld", static_cast<unsigned long long>(seed),
+                                  static_cast<long long>(frameIndex)),
+                cv::Point(10, std::max(20, size.height / 12)), cv::FONT_HERSHEY_SIMPLEX,
+                std::max(0.5, size.height / 720.0), cv::Scalar(255, 255, 255), 2);
+}
+
+int runSimulatorCheck(const SimulatorConfig &config, std::size_t sampleCount)
+{
+    // Первый имитатор - одной пачкой, второй - пачками разного размера,
+    // как при неровном опросе из GUI
+    SensorSimulator reference(config);
+    SensorSimulator replica(config);
+    std::vector<telemetry::Sample> expected;
+    std::vector<telemetry::Sample> actual;
+    reference.generate(sampleCount, expected);
+    for (std::size_t batch = 1; actual.size() < sampleCount; batch = batch % 997 + 7) {
+        replica.generate(std::min(batch, sampleCount - actual.size()), actual);
+    }
+
+    // Начальная метка берётся с часов, сравниваются смещения от неё
+    bool ok = expected.size() == actual.size() && reference.faultCount() == replica.faultCount();
+    quint64 digest = 0xCBF29CE484222325ULL;
+    std::size_t mismatch = sampleCount;
+    for (std::size_t n = 0; n < expected.size(); ++n) {
+        const qint64 offset = expected[n].timestampMs - expected.front().timestampMs;
+        bool same = offset == actual[n].timestampMs - actual.front().timestampMs;
+        digest = fnv1a(digest, &offset, sizeof(offset));
+        telemetry::forEachChannel([&](auto index, const auto &) {
+            constexpr std::size_t I = decltype(index)::value;
+            const auto value = expected[n].template get<I>();
+            same = same && std::memcmp(&value, &actual[n].template get<I>(), sizeof(value)) == 0;
+            digest = fnv1a(digest, &value, sizeof(value));
+        });
+        if (!same && mismatch == sampleCount) {
+            mismatch = n;
+        }
+    }
+    ok = ok && mismatch == sampleCount;
+
+    // Синтетическое видео: первые кадры двух камер с одним seed
+    const int kCheckedFrames = 5;
+    bool videoOk = true;
+    if (config.syntheticVideo) {
+        SyntheticCamera first(config.seed, config.videoSize, config.videoFps);
+        SyntheticCamera second(config.seed, config.videoSize, config.videoFps);
+        videoOk = first.open() && second.open();
+        cv::Mat a, b;
+        for (int i = 0; videoOk && i < kCheckedFrames; ++i) {
+            videoOk = first.read(a) && second.read(b) && cv::norm(a, b, cv::NORM_INF) == 0;
+            if (videoOk) {
+                digest = fnv1a(digest, a.data, a.total() * a.elemSize());
+            }
+        }
+    }
+
+    std::printf("Seed:         %llu\n", static_cast<unsigned long long>(config.seed));
+    std::printf("Rate:         %d Hz, faults/min %.2f\n", config.sensorRateHz, config.faultsPerMinute);
+    std::printf("Samples:      %zu, faults %llu\n", expected.size(),
+                static_cast<unsigned long long>(reference.faultCount()));
+    if (mismatch != sampleCount) {
+        std::printf("Mismatch:     sample %zu\n", mismatch);
+    }
+    if (config.syntheticVideo) {
+        std::printf("Video:        %dx%d, %d frames %s\n", config.videoSize.width, config.videoSize.height,
+                    kCheckedFrames, videoOk ? "OK" : "MISMATCH");
+    }
+    std::printf("Digest:       %016llx\n", static_cast<unsigned long long>(digest));
+    std::printf("Determinism:  %s\n", ok && videoOk ? "OK" : "MISMATCH");
+    return ok && videoOk ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#ifndef ROBOTSIMULATOR_H
+#define ROBOTSIMULATOR_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "capturesource.h"
+#include "telemetrysource.h"
+
+// Параметры имитатора робота (ключи --sim-* командной строки)
+struct SimulatorConfig
+{
+    quint64 seed = 1;
+    int sensorRateHz = telemetry::maxRateHz();
+    double faultsPerMinute = 0.0;
+    // Синтетическое видео вместо камер
+    bool syntheticVideo = false;
+    cv::Size videoSize{640, 480};
+    int videoFps = 30;
+};
+
+// Случайные числа, одинаковые при любой стандартной библиотеке: движок
+// mt19937_64 стандартизован до бита, а std::*_distribution - нет
+// (libstdc++, libc++ и MSVC дают при одном seed разные числа).
+// Нормальное распределение - преобразование Бокса-Мюллера.
+class PortableRandom
+{
+public:
+    explicit PortableRandom(quint64 seed);
+
+    // [0, 1)
+    double uniform();
+    // [low, high]
+    int uniformInt(int low, int high);
+    // N(0, 1)
+    double normal();
+
+private:
+    std::mt19937_64 engine;
+    bool haveSpare;
+    double spare;
+};
+
+// Имитатор датчиков. Значения каналов - процессы Орнштейна-Уленбека
+// вокруг середины диапазона из схемы плюс шум измерения, заряд батареи
+// разряжается и восстанавливается. Каждый канал обновляется со своей
+// частотой rateHz из схемы, между обновлениями отсчёты повторяют его
+// последнее значение. Сбои: пропадание связи (пауза
+// в потоке), залипание датчика и одиночный выброс за диапазон.
+// Отсчёты генерируются строго по порядку из одного генератора, поэтому
+// при одном seed последовательность значений одна и та же при любом
+// темпе опроса; меняется только начальная метка времени. Между
+// платформами она совпадает, пока совпадают exp/log/cos библиотеки
+// математики (последний бит сглаживается округлением до точности канала).
+class SensorSimulator : public TelemetrySource
+{
+public:
+    explicit SensorSimulator(const SimulatorConfig &config);
+
+    QString name() const override;
+    void start() override;
+    void stop() override;
+    void poll(std::vector<telemetry::Sample> &out) override;
+
+    // Следующие count отсчётов без привязки к часам (для замеров)
+    void generate(std::size_t count, std::vector<telemetry::Sample> &out);
+    quint64 faultCount() const { return faults; }
+
+private:
+    enum class Fault { Dropout, Stuck, Spike };
+
+    bool next(telemetry::Sample &sample);
+    // Обновляется ли канал с частотой rateHz в отсчёте index
+    bool updatesAt(quint64 index, int rateHz) const;
+    void startFault(quint64 index);
+    qint64 timestampOf(quint64 index) const;
+
+    SimulatorConfig config;
+    PortableRandom random;
+    double faultProbability;
+
+    QElapsedTimer clock;
+    qint64 baseMs;
+    quint64 startIndex;
+    quint64 sampleIndex;
+    telemetry::Sample previous;
+    std::array<double, telemetry::kChannelCount> levels;
+    // Номер отсчёта последнего обновления канала
+    std::array<quint64, telemetry::kChannelCount> updatedAt;
+
+    // Активные сбои
+    quint64 dropoutUntil;
+    std::array<quint64, telemetry::kChannelCount> stuckUntil;
+    int spikeChannel;
+    quint64 faults;
+};
+
+// Синтетическая камера: кадры заданного размера с заданной частотой.
+// Картинка - функция seed и номера кадра (градиент, движущийся
+// прямоугольник, номер кадра), поэтому прогоны воспроизводимы.
+class SyntheticCamera : public FrameDevice
+{
+public:
+    SyntheticCamera(quint64 seed, cv::Size size, int fps);
+
+    bool open() override;
+    bool grab() override;
+    bool retrieve(cv::Mat &frame) override;
+
+private:
+    void render(cv::Mat &frame) const;
+
+    quint64 seed;
+    cv::Size size;
+    int fps;
+    cv::Point origin;
+    cv::Point velocity;
+    cv::Scalar color;
+    std::chrono::steady_clock::time_point startTime;
+    qint64 frameIndex;
+};
+
+// Проверка воспроизводимости без окна: два имитатора с одним seed,
+// опрашиваемые пачками разного размера, должны выдать одни и те же
+// sampleCount отсчётов (и кадры синтетического видео). Печатает
+// контрольную сумму прогона для сравнения между машинами;
+// запускается ключом --sim-check
+int runSimulatorCheck(const SimulatorConfig &config, std::size_t sampleCount);
+
+#endif // ROBOTSIMULATOR_H
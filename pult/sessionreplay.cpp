@@ -0,0 +1,531 @@
+#include "sessionreplay.h"
+#include "telemetrycodec.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Каждая N-я строка текстовой записи попадает в разреженный индекс;
+// в двоичной записи индексируется каждый блок
+const int kIndexStride = 64;
+// Отсчётов телеметрии и меток кадров в одном блоке двоичной записи
+const std::size_t kSampleBlockSize = 256;
+const std::size_t kFrameBlockSize = 1024;
+const char kRecordingMagic[] = "TLM2";
+const quint8 kFrameChunk = 'F';
+const quint8 kTelemetryChunk = 'T';
+const quint32 kIndexMagic = 0x544C4D49;  // "TLMI"
+// 2 - записи TLM2: смещения указывают на блоки, а не на строки
+const quint32 kIndexVersion = 2;
+// Период таймера воспроизведения
+const int kTickMs = 10;
+// Если до нужного кадра меньше этого числа кадров - дочитываем,
+// иначе позиционируем декодер напрямую
+const int kMaxSequentialSkip = 8;
+
+bool parseRecord(const QByteArray &line, telemetry::Sample &record)
+{
+    const QList<QByteArray> parts = line.trimmed().split(' ');
+    if (parts.size() < 3 || parts[0] != "T") {
+        return false;
+    }
+    bool ok = false;
+    record = telemetry::Sample();
+    record.timestampMs = parts[1].toLongLong(&ok);
+    return ok && telemetry::parseFields(parts, 2, record);
+}
+
+} // namespace
+
+SessionReplay::SessionReplay(QObject *parent)
+    : QObject(parent),
+      binaryFormat(false),
+      startMs(0),
+      endMs(0),
+      anchorPosition(0),
+      playSpeed(1.0),
+      historyWindowMs(60 * 1000),
+      playing(false),
+      currentFrame(-1),
+      hasPending(false),
+      pending(),
+      blockPosition(0)
+{
+    playTimer = new QTimer(this);
+    playTimer->setTimerType(Qt::PreciseTimer);
+    connect(playTimer, &QTimer::timeout, this, &SessionReplay::tick);
+}
+
+SessionReplay::~SessionReplay()
+{
+    close();
+}
+
+QString SessionReplay::telemetryPathFor(const QString &videoPath)
+{
+    QFileInfo info(videoPath);
+    return info.path() + "/" + info.completeBaseName() + ".tlm";
+}
+
+bool SessionReplay::open(const QString &videoPath, QString *error)
+{
+    close();
+
+    const QString telemetryPath = telemetryPathFor(videoPath);
+    telemetryFile.setFileName(telemetryPath);
+    if (!telemetryFile.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("Не найден файл телеметрии: %1").arg(telemetryPath);
+        return false;
+    }
+    binaryFormat = telemetryFile.peek(4) == QByteArray(kRecordingMagic, 4);
+
+    const QString indexPath = telemetryPath + ".idx";
+    if (!loadIndex(indexPath)) {
+        if (!buildIndex()) {
+            if (error) *error = "Файл телеметрии пуст или повреждён";
+            telemetryFile.close();
+            return false;
+        }
+        saveIndex(indexPath);
+    }
+
+    if (!frameTimes.isEmpty()) {
+        video.open(videoPath.toStdString());
+        if (!video.isOpened()) {
+            if (error) *error = QString("Не удалось открыть видео: %1").arg(videoPath);
+            telemetryFile.close();
+            return false;
+        }
+        // Кадров в файле может оказаться меньше, чем строк F (обрыв записи)
+        const int frameCount = static_cast<int>(video.get(cv::CAP_PROP_FRAME_COUNT));
+        if (frameCount > 0 && frameCount < frameTimes.size()) {
+            frameTimes.resize(frameCount);
+        }
+    }
+
+    seek(0);
+    return true;
+}
+
+void SessionReplay::close()
+{
+    pause();
+    if (video.isOpened()) {
+        video.release();
+    }
+    telemetryFile.close();
+    frameTimes.clear();
+    telemetryIndex.clear();
+    startMs = endMs = 0;
+    anchorPosition = 0;
+    currentFrame = -1;
+    hasPending = false;
+    block.clear();
+    blockPosition = 0;
+}
+
+bool SessionReplay::isOpen() const
+{
+    return telemetryFile.isOpen();
+}
+
+qint64 SessionReplay::durationMs() const
+{
+    return endMs - startMs;
+}
+
+qint64 SessionReplay::positionMs() const
+{
+    if (!playing) {
+        return anchorPosition;
+    }
+    const qint64 position = anchorPosition + static_cast<qint64>(clock.elapsed() * playSpeed);
+    return std::min(position, durationMs());
+}
+
+bool SessionReplay::isPlaying() const
+{
+    return playing;
+}
+
+double SessionReplay::speed() const
+{
+    return playSpeed;
+}
+
+void SessionReplay::play()
+{
+    if (!isOpen() || playing) {
+        return;
+    }
+    if (anchorPosition >= durationMs()) {
+        seek(0);
+    }
+    playing = true;
+    clock.start();
+    playTimer->start(kTickMs);
+}
+
+void SessionReplay::pause()
+{
+    if (!playing) {
+        return;
+    }
+    anchorPosition = positionMs();
+    playing = false;
+    playTimer->stop();
+}
+
+void SessionReplay::setSpeed(double speed)
+{
+    if (speed <= 0.0) {
+        return;
+    }
+    // Переякорим часы, чтобы смена скорости не вызывала скачка позиции
+    anchorPosition = positionMs();
+    clock.restart();
+    playSpeed = speed;
+}
+
+void SessionReplay::seek(qint64 positionMs)
+{
+    seekTo(positionMs, historyWindowMs);
+}
+
+void SessionReplay::scrub(qint64 positionMs)
+{
+    seekTo(positionMs, 0);
+}
+
+void SessionReplay::seekTo(qint64 positionMs, qint64 windowMs)
+{
+    if (!isOpen()) {
+        return;
+    }
+    anchorPosition = std::clamp<qint64>(positionMs, 0, durationMs());
+    clock.restart();
+
+    const qint64 timestamp = startMs + anchorPosition;
+    showFrameAt(timestamp);
+    seekTelemetry(timestamp, windowMs);
+    emit positionChanged(anchorPosition);
+}
+
+void SessionReplay::setHistoryWindow(qint64 windowMs)
+{
+    historyWindowMs = std::max<qint64>(0, windowMs);
+}
+
+void SessionReplay::tick()
+{
+    const qint64 position = positionMs();
+    const qint64 timestamp = startMs + position;
+
+    showFrameAt(timestamp);
+    emitTelemetryUntil(timestamp);
+    emit positionChanged(position);
+
+    if (position >= durationMs()) {
+        pause();
+        emit finished();
+    }
+}
+
+void SessionReplay::showFrameAt(qint64 timestampMs)
+{
+    if (frameTimes.isEmpty()) {
+        return;
+    }
+    auto it = std::upper_bound(frameTimes.cbegin(), frameTimes.cend(), timestampMs);
+    const int target = std::max(0, static_cast<int>(it - frameTimes.cbegin()) - 1);
+    if (target == currentFrame) {
+        return;
+    }
+
+    const int gap = target - currentFrame;
+    if (currentFrame < 0 || gap < 1 || gap > kMaxSequentialSkip) {
+        video.set(cv::CAP_PROP_POS_FRAMES, target);
+    } else {
+        // Пропускаем кадры без декодирования в RGB
+        for (int i = 1; i < gap; ++i) {
+            video.grab();
+        }
+    }
+
+    cv::Mat frame;
+    if (video.read(frame) && !frame.empty()) {
+        currentFrame = target;
+        emit frameReady(frame);
+    } else {
+        currentFrame = -1;
+    }
+}
+
+void SessionReplay::seekTelemetry(qint64 timestampMs, qint64 windowMs)
+{
+    hasPending = false;
+    if (telemetryIndex.isEmpty()) {
+        return;
+    }
+
+    // Читаем с начала окна истории, чтобы на графиках не было пропуска
+    // перед новой позицией; до начала окна - не больше kIndexStride строк
+    // (или одного блока). При windowMs == 0 остаётся только текущий отсчёт
+    const qint64 windowStart = timestampMs - windowMs;
+    auto it = std::upper_bound(telemetryIndex.cbegin(), telemetryIndex.cend(), windowStart,
+                               [](qint64 ts, const IndexEntry &entry) {
+                                   return ts < entry.timestampMs;
+                               });
+    if (it != telemetryIndex.cbegin()) {
+        --it;
+    }
+    telemetryFile.seek(it->offset);
+    block.clear();
+    blockPosition = 0;
+
+    std::vector<telemetry::Sample> window;
+    telemetry::Sample record;
+    telemetry::Sample current;
+    bool haveCurrent = false;
+    while (readRecord(record)) {
+        if (record.timestampMs > timestampMs) {
+            pending = record;
+            hasPending = true;
+            break;
+        }
+        if (record.timestampMs >= windowStart) {
+            window.push_back(record);
+        }
+        current = record;
+        haveCurrent = true;
+    }
+    // Текущий отсчёт нужен и тогда, когда он раньше начала окна
+    if (window.empty() && haveCurrent) {
+        window.push_back(current);
+    }
+    emit historyLoaded(window);
+}
+
+void SessionReplay::emitTelemetryUntil(qint64 timestampMs)
+{
+    while (true) {
+        if (!hasPending) {
+            if (!readRecord(pending)) {
+                return;
+            }
+            hasPending = true;
+        }
+        if (pending.timestampMs > timestampMs) {
+            return;
+        }
+        hasPending = false;
+        emit sampleReady(pending);
+    }
+}
+
+bool SessionReplay::readRecord(telemetry::Sample &record)
+{
+    if (binaryFormat) {
+        // Следующий отсчёт из текущего блока, иначе распаковываем следующий
+        // блок телеметрии, пропуская блоки меток кадров
+        QDataStream in(&telemetryFile);
+        while (blockPosition >= block.size()) {
+            if (telemetryFile.atEnd()) {
+                return false;
+            }
+            const qint64 offset = telemetryFile.pos();
+            quint8 type = 0;
+            qint64 first = 0, last = 0;
+            QByteArray payload;
+            in >> type >> first >> last >> payload;
+            if (in.status() != QDataStream::Ok) {
+                qWarning() << "[REPLAY] truncated telemetry chunk at" << offset;
+                return false;
+            }
+            if (type == kTelemetryChunk) {
+                block.clear();
+                blockPosition = 0;
+                // Границы блока целы (длина прочитана), поэтому испорченный
+                // блок пропускается и чтение идёт со следующего
+                if (!telemetry::decodeBlock(payload, block)) {
+                    qWarning() << "[REPLAY] corrupt telemetry chunk at" << offset << "skipped";
+                    block.clear();
+                }
+            }
+        }
+        record = block[blockPosition++];
+        return true;
+    }
+
+    while (!telemetryFile.atEnd()) {
+        const QByteArray line = telemetryFile.readLine();
+        if (parseRecord(line, record)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SessionReplay::buildIndex()
+{
+    frameTimes.clear();
+    telemetryIndex.clear();
+    startMs = std::numeric_limits<qint64>::max();
+    endMs = std::numeric_limits<qint64>::min();
+
+    if (binaryFormat) {
+        return buildBinaryIndex();
+    }
+
+    telemetryFile.seek(0);
+    int records = 0;
+    while (!telemetryFile.atEnd()) {
+        const qint64 offset = telemetryFile.pos();
+        const QByteArray line = telemetryFile.readLine();
+        if (line.startsWith("F ")) {
+            bool ok = false;
+            const qint64 ts = line.mid(2).trimmed().toLongLong(&ok);
+            if (!ok) continue;
+            frameTimes.append(ts);
+            startMs = std::min(startMs, ts);
+            endMs = std::max(endMs, ts);
+        } else {
+            telemetry::Sample record;
+            if (!parseRecord(line, record)) continue;
+            if (records % kIndexStride == 0) {
+                telemetryIndex.append({record.timestampMs, offset});
+            }
+            ++records;
+            startMs = std::min(startMs, record.timestampMs);
+            endMs = std::max(endMs, record.timestampMs);
+        }
+    }
+
+    if (frameTimes.isEmpty() && telemetryIndex.isEmpty()) {
+        startMs = endMs = 0;
+        return false;
+    }
+    return true;
+}
+
+bool SessionReplay::buildBinaryIndex()
+{
+    telemetryFile.seek(4);
+    QDataStream in(&telemetryFile);
+    while (!telemetryFile.atEnd()) {
+        const qint64 offset = telemetryFile.pos();
+        quint8 type = 0;
+        qint64 first = 0, last = 0;
+        in >> type >> first >> last;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+
+        if (type == kFrameChunk) {
+            QByteArray payload;
+            in >> payload;
+            std::vector<qint64> times;
+            if (in.status() != QDataStream::Ok || !telemetry::decodeTimestamps(payload, times)) {
+                break;
+            }
+            for (qint64 ts : times) {
+                frameTimes.append(ts);
+            }
+        } else {
+            // Блок телеметрии не распаковываем: в индекс идут его смещение
+            // и первая метка, содержимое пропускается
+            quint32 size = 0;
+            in >> size;
+            if (in.status() != QDataStream::Ok) {
+                break;
+            }
+            if (size != 0xFFFFFFFF) {
+                telemetryFile.seek(telemetryFile.pos() + size);
+            }
+            if (type == kTelemetryChunk) {
+                telemetryIndex.append({first, offset});
+            }
+        }
+        startMs = std::min(startMs, first);
+        endMs = std::max(endMs, last);
+    }
+
+    if (frameTimes.isEmpty() && telemetryIndex.isEmpty()) {
+        startMs = endMs = 0;
+        return false;
+    }
+    return true;
+}
+
+bool SessionReplay::writeTelemetry(const QString &path, const std::vector<qint64> &frameTimes,
+                                   const std::vector<telemetry::Sample> &samples)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.writeRawData(kRecordingMagic, 4);
+    for (std::size_t first = 0; first < frameTimes.size(); first += kFrameBlockSize) {
+        const std::size_t count = std::min(kFrameBlockSize, frameTimes.size() - first);
+        out << kFrameChunk << frameTimes[first] << frameTimes[first + count - 1]
+            << telemetry::encodeTimestamps(frameTimes.data() + first, count);
+    }
+    for (std::size_t first = 0; first < samples.size(); first += kSampleBlockSize) {
+        const std::size_t count = std::min(kSampleBlockSize, samples.size() - first);
+        out << kTelemetryChunk << samples[first].timestampMs << samples[first + count - 1].timestampMs
+            << telemetry::encodeBlock(samples.data() + first, count);
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool SessionReplay::loadIndex(const QString &indexPath)
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0;
+    qint64 sourceSize = 0, sourceModified = 0;
+    in >> magic >> version >> sourceSize >> sourceModified;
+
+    // Индекс устарел, если файл телеметрии изменился
+    const QFileInfo source(telemetryFile.fileName());
+    if (magic != kIndexMagic || version != kIndexVersion
+        || sourceSize != source.size()
+        || sourceModified != source.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    qint32 entries = 0;
+    in >> startMs >> endMs >> frameTimes >> entries;
+    telemetryIndex.resize(std::max(0, entries));
+    for (IndexEntry &entry : telemetryIndex) {
+        in >> entry.timestampMs >> entry.offset;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+void SessionReplay::saveIndex(const QString &indexPath) const
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    const QFileInfo source(telemetryFile.fileName());
+    QDataStream out(&file);
+    out << kIndexMagic << kIndexVersion
+        << source.size() << source.lastModified().toMSecsSinceEpoch();
+    out << startMs << endMs << frameTimes << static_cast<qint32>(telemetryIndex.size());
+    for (const IndexEntry &entry : telemetryIndex) {
+        out << entry.timestampMs << entry.offset;
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef SESSIONREPLAY_H
+#define SESSIONREPLAY_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QString>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "telemetryschema.h"
+
+// Воспроизведение записанной сессии: видео (video_*.mp4) + файл
+// телеметрии рядом с ним (video_*.tlm). Формат .tlm - "TLM2" и блоки
+//   <тип 'F'|'T'> <первая метка> <последняя метка> <QByteArray>
+// где 'F' - метки времени кадров (k-я метка = k-й кадр), 'T' - блок
+// отсчётов телеметрии; оба сжаты telemetry-кодеком. Старые текстовые
+// записи (строки "F <ms>" и "T <ms> <значения>") тоже читаются.
+// При открытии строится (или загружается из .tlm.idx) индекс: метки
+// времени кадров и смещения блоков телеметрии, поэтому перемотка
+// не требует чтения файлов целиком.
+class SessionReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SessionReplay(QObject *parent = nullptr);
+    ~SessionReplay();
+
+    bool open(const QString &videoPath, QString *error = nullptr);
+    void close();
+    bool isOpen() const;
+
+    qint64 durationMs() const;
+    qint64 positionMs() const;
+    bool isPlaying() const;
+    double speed() const;
+
+    void play();
+    void pause();
+    void setSpeed(double speed);
+    // Перемотка с перезагрузкой истории на всё окно графиков
+    void seek(qint64 positionMs);
+    // Перемотка при перетаскивании ползунка: только кадр и текущий
+    // отсчёт, цена не зависит от окна; историю загрузит seek() по
+    // отпусканию ползунка
+    void scrub(qint64 positionMs);
+    // Сколько телеметрии до позиции заново загружать при seek()
+    // (окно графиков)
+    void setHistoryWindow(qint64 windowMs);
+
+    // Путь к файлу телеметрии для видеофайла
+    static QString telemetryPathFor(const QString &videoPath);
+    // Записывает файл телеметрии сессии
+    static bool writeTelemetry(const QString &path, const std::vector<qint64> &frameTimes,
+                               const std::vector<telemetry::Sample> &samples);
+
+signals:
+    void frameReady(const cv::Mat &frame);
+    void sampleReady(const telemetry::Sample &sample);
+    // После перемотки: отсчёты окна истории до новой позиции по порядку,
+    // последний - текущий (после scrub() - только он). Заменяет историю,
+    // а не дополняет её
+    void historyLoaded(const std::vector<telemetry::Sample> &samples);
+    void positionChanged(qint64 positionMs);
+    void finished();
+
+private slots:
+    void tick();
+
+private:
+    struct IndexEntry
+    {
+        qint64 timestampMs;
+        qint64 offset;
+    };
+
+    bool loadIndex(const QString &indexPath);
+    bool buildIndex();
+    bool buildBinaryIndex();
+    void saveIndex(const QString &indexPath) const;
+    bool readRecord(telemetry::Sample &record);
+    void showFrameAt(qint64 timestampMs);
+    void seekTo(qint64 positionMs, qint64 windowMs);
+    void seekTelemetry(qint64 timestampMs, qint64 windowMs);
+    void emitTelemetryUntil(qint64 timestampMs);
+
+    cv::VideoCapture video;
+    QFile telemetryFile;
+    bool binaryFormat;
+    QTimer *playTimer;
+    QElapsedTimer clock;
+
+    // Индекс сессии
+    QVector<qint64> frameTimes;
+    QVector<IndexEntry> telemetryIndex;
+    qint64 startMs;
+    qint64 endMs;
+
+    // Состояние воспроизведения
+    qint64 anchorPosition;
+    double playSpeed;
+    qint64 historyWindowMs;
+    bool playing;
+    int currentFrame;
+    bool hasPending;
+    telemetry::Sample pending;
+    // Текущий распакованный блок телеметрии (двоичный формат)
+    std::vector<telemetry::Sample> block;
+    std::size_t blockPosition;
+};
+
+#endif // SESSIONREPLAY_H
@@ -0,0 +1,530 @@
+#include "telemetrycodec.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace telemetry {
+
+namespace {
+
+// Защита от испорченного заголовка блока
+const quint64 kMaxBlockSamples = 1u << 24;
+// Метки времени - мс от эпохи, не позже 9999 года; всё, что выходит за
+// [0, kMaxTimestampMs], декодер считает порчей блока
+const quint64 kMaxTimestampMs = 253402300799999ULL;
+
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray &out) : out(out), accumulator(0), pending(0) {}
+
+    void write(quint64 value, int count)
+    {
+        if (count > 32) {
+            write(value >> 32, count - 32);
+            count = 32;
+        }
+        if (count <= 0) {
+            return;
+        }
+        value &= (count == 64) ? ~0ull : ((1ull << count) - 1);
+        accumulator = (accumulator << count) | value;
+        pending += count;
+        while (pending >= 8) {
+            pending -= 8;
+            out.append(static_cast<char>(accumulator >> pending));
+        }
+    }
+
+    void writeBit(bool bit) { write(bit ? 1 : 0, 1); }
+
+    void writeVarint(quint64 value)
+    {
+        while (value >= 0x80) {
+            write((value & 0x7F) | 0x80, 8);
+            value >>= 7;
+        }
+        write(value, 8);
+    }
+
+    void flush()
+    {
+        if (pending > 0) {
+            out.append(static_cast<char>(accumulator << (8 - pending)));
+            pending = 0;
+        }
+    }
+
+private:
+    QByteArray &out;
+    quint64 accumulator;
+    int pending;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const QByteArray &in)
+        : data(reinterpret_cast<const uchar *>(in.constData())),
+          size(static_cast<std::size_t>(in.size())),
+          position(0),
+          accumulator(0),
+          available(0)
+    {
+    }
+
+    quint64 read(int count)
+    {
+        if (count > 32) {
+            const quint64 high = read(count - 32);
+            return (high << 32) | read(32);
+        }
+        while (available < count) {
+            accumulator = (accumulator << 8) | (position < size ? data[position] : 0);
+            ++position;
+            available += 8;
+        }
+        available -= count;
+        return (accumulator >> available) & ((1ull << count) - 1);
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+    quint64 readVarint()
+    {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const quint64 byte = read(8);
+            value |= (byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    // Чтение за концом блока - блок повреждён
+    bool overrun() const { return position > size; }
+
+private:
+    const uchar *data;
+    std::size_t size;
+    std::size_t position;
+    quint64 accumulator;
+    int available;
+};
+
+// Разности считаются в quint64: при скачке времени или в испорченном
+// блоке они заворачиваются по модулю 2^64, а не дают переполнения
+// знакового. Знаковым значение становится только в самом конце
+quint64 zigzag(quint64 value)
+{
+    return (value << 1) ^ (0 - (value >> 63));
+}
+
+quint64 unzigzag(quint64 value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+// Шаг метки: разность в дополнительном коде и результат - в допустимом
+// диапазоне; иначе false и метка не меняется
+bool applyTimestampDelta(quint64 &timestamp, quint64 delta)
+{
+    const bool forward = (delta >> 63) == 0;
+    const quint64 magnitude = forward ? delta : 0 - delta;
+    if (magnitude > kMaxTimestampMs) {
+        return false;
+    }
+    if (forward ? magnitude > kMaxTimestampMs - timestamp : magnitude > timestamp) {
+        return false;
+    }
+    timestamp = forward ? timestamp + magnitude : timestamp - magnitude;
+    return true;
+}
+
+quint64 doubleBits(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(quint64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Метки времени: первая целиком, затем первая разность, затем
+// разность разностей в корзинах '0' / '10'+7 / '110'+9 / '1110'+12 / '1111'+64
+template<typename Get>
+void writeTimestamps(BitWriter &writer, std::size_t count, Get get)
+{
+    if (count == 0) {
+        return;
+    }
+    auto bits = [&get](std::size_t i) { return static_cast<quint64>(get(i)); };
+    writer.write(bits(0), 64);
+    if (count == 1) {
+        return;
+    }
+    quint64 previousDelta = bits(1) - bits(0);
+    writer.writeVarint(zigzag(previousDelta));
+    for (std::size_t i = 2; i < count; ++i) {
+        const quint64 delta = bits(i) - bits(i - 1);
+        const quint64 dod = zigzag(delta - previousDelta);
+        previousDelta = delta;
+        if (dod == 0) {
+            writer.write(0b0, 1);
+        } else if (dod < (1u << 7)) {
+            writer.write(0b10, 2);
+            writer.write(dod, 7);
+        } else if (dod < (1u << 9)) {
+            writer.write(0b110, 3);
+            writer.write(dod, 9);
+        } else if (dod < (1u << 12)) {
+            writer.write(0b1110, 4);
+            writer.write(dod, 12);
+        } else {
+            writer.write(0b1111, 4);
+            writer.write(dod, 64);
+        }
+    }
+}
+
+// false - метка вышла из допустимого диапазона (испорченный блок)
+template<typename Set>
+bool readTimestamps(BitReader &reader, std::size_t count, Set set)
+{
+    if (count == 0) {
+        return true;
+    }
+    quint64 previous = reader.read(64);
+    if (previous > kMaxTimestampMs) {
+        return false;
+    }
+    set(0, static_cast<qint64>(previous));
+    if (count == 1) {
+        return true;
+    }
+    quint64 delta = unzigzag(reader.readVarint());
+    if (!applyTimestampDelta(previous, delta)) {
+        return false;
+    }
+    set(1, static_cast<qint64>(previous));
+    for (std::size_t i = 2; i < count; ++i) {
+        quint64 dod = 0;
+        if (!reader.readBit()) {
+            dod = 0;
+        } else if (!reader.readBit()) {
+            dod = reader.read(7);
+        } else if (!reader.readBit()) {
+            dod = reader.read(9);
+        } else if (!reader.readBit()) {
+            dod = reader.read(12);
+        } else {
+            dod = reader.read(64);
+        }
+        delta += unzigzag(dod);
+        if (!applyTimestampDelta(previous, delta)) {
+            return false;
+        }
+        set(i, static_cast<qint64>(previous));
+    }
+    return true;
+}
+
+// Вещественный столбец: XOR с предыдущим значением. '0' - без изменений,
+// '10' - значимые биты в окне предыдущего значения, '11' - новое окно
+// (5 бит ведущих нулей, 6 бит длины-1) и значимые биты
+class XorEncoder
+{
+public:
+    void write(BitWriter &writer, quint64 bits, bool first)
+    {
+        if (first) {
+            writer.write(bits, 64);
+            previous = bits;
+            return;
+        }
+        const quint64 x = bits ^ previous;
+        previous = bits;
+        if (x == 0) {
+            writer.write(0b0, 1);
+            return;
+        }
+        int leading = qCountLeadingZeroBits(x);
+        const int trailing = qCountTrailingZeroBits(x);
+        if (leading > 31) {
+            leading = 31;
+        }
+        if (windowLeading >= 0 && leading >= windowLeading && trailing >= windowTrailing) {
+            writer.write(0b10, 2);
+            writer.write(x >> windowTrailing, 64 - windowLeading - windowTrailing);
+            return;
+        }
+        const int meaningful = 64 - leading - trailing;
+        writer.write(0b11, 2);
+        writer.write(static_cast<quint64>(leading), 5);
+        writer.write(static_cast<quint64>(meaningful - 1), 6);
+        writer.write(x >> trailing, meaningful);
+        windowLeading = leading;
+        windowTrailing = trailing;
+    }
+
+private:
+    quint64 previous = 0;
+    int windowLeading = -1;
+    int windowTrailing = 0;
+};
+
+class XorDecoder
+{
+public:
+    quint64 read(BitReader &reader, bool first)
+    {
+        if (first) {
+            previous = reader.read(64);
+            return previous;
+        }
+        if (!reader.readBit()) {
+            return previous;
+        }
+        if (reader.readBit()) {
+            windowLeading = static_cast<int>(reader.read(5));
+            const int meaningful = static_cast<int>(reader.read(6)) + 1;
+            windowTrailing = 64 - windowLeading - meaningful;
+            if (windowTrailing < 0) {
+                windowTrailing = 0;
+            }
+        }
+        const int meaningful = 64 - windowLeading - windowTrailing;
+        previous ^= reader.read(meaningful) << windowTrailing;
+        return previous;
+    }
+
+private:
+    quint64 previous = 0;
+    int windowLeading = 0;
+    int windowTrailing = 0;
+};
+
+double precisionScale(int precision)
+{
+    return std::pow(10.0, precision);
+}
+
+} // namespace
+
+QByteArray encodeBlock(const Sample *samples, std::size_t count)
+{
+    QByteArray out;
+    out.reserve(static_cast<int>(16 + count * 8));
+    BitWriter writer(out);
+    writer.writeVarint(count);
+
+    writeTimestamps(writer, count, [samples](std::size_t i) { return samples[i].timestampMs; });
+
+    forEachChannel([&](auto index, const auto &channel) {
+        constexpr std::size_t I = decltype(index)::value;
+        using T = ValueType<I>;
+        if constexpr (std::is_floating_point_v<T>) {
+            // Целое число единиц точности как double: у такого значения
+            // много нулевых младших бит, и XOR соседних значений короткий
+            const double scale = precisionScale(channel.precision);
+            XorEncoder encoder;
+            for (std::size_t i = 0; i < count; ++i) {
+                const double quantized = std::round(samples[i].template get<I>() * scale);
+                encoder.write(writer, doubleBits(quantized), i == 0);
+            }
+        } else {
+            quint64 previous = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                const quint64 value = static_cast<quint64>(static_cast<qint64>(samples[i].template get<I>()));
+                if (i == 0) {
+                    writer.writeVarint(zigzag(value));
+                } else if (value == previous) {
+                    writer.writeBit(false);
+                } else {
+                    writer.writeBit(true);
+                    writer.writeVarint(zigzag(value - previous));
+                }
+                previous = value;
+            }
+        }
+    });
+
+    writer.flush();
+    return out;
+}
+
+bool decodeBlock(const QByteArray &block, std::vector<Sample> &samples)
+{
+    BitReader reader(block);
+    const quint64 count = reader.readVarint();
+    // Каждый отсчёт занимает хотя бы бит в каждом столбце
+    if (count > kMaxBlockSamples || count > static_cast<quint64>(block.size()) * 8 || reader.overrun()) {
+        return false;
+    }
+    const std::size_t base = samples.size();
+    samples.resize(base + count);
+    Sample *out = samples.data() + base;
+
+    if (!readTimestamps(reader, count, [out](std::size_t i, qint64 value) { out[i].timestampMs = value; })) {
+        samples.resize(base);
+        return false;
+    }
+
+    forEachChannel([&](auto index, const auto &channel) {
+        constexpr std::size_t I = decltype(index)::value;
+        using T = ValueType<I>;
+        if constexpr (std::is_floating_point_v<T>) {
+            const double scale = precisionScale(channel.precision);
+            XorDecoder decoder;
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i].template get<I>() = static_cast<T>(bitsDouble(decoder.read(reader, i == 0)) / scale);
+            }
+        } else {
+            quint64 previous = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (i == 0) {
+                    previous = unzigzag(reader.readVarint());
+                } else if (reader.readBit()) {
+                    previous += unzigzag(reader.readVarint());
+                }
+                out[i].template get<I>() = static_cast<T>(static_cast<qint64>(previous));
+            }
+        }
+    });
+
+    if (reader.overrun()) {
+        samples.resize(base);
+        return false;
+    }
+    return true;
+}
+
+QByteArray encodeTimestamps(const qint64 *timestamps, std::size_t count)
+{
+    QByteArray out;
+    BitWriter writer(out);
+    writer.writeVarint(count);
+    writeTimestamps(writer, count, [timestamps](std::size_t i) { return timestamps[i]; });
+    writer.flush();
+    return out;
+}
+
+bool decodeTimestamps(const QByteArray &block, std::vector<qint64> &timestamps)
+{
+    BitReader reader(block);
+    const quint64 count = reader.readVarint();
+    if (count > kMaxBlockSamples || count > static_cast<quint64>(block.size()) * 8 || reader.overrun()) {
+        return false;
+    }
+    const std::size_t base = timestamps.size();
+    timestamps.resize(base + count);
+    qint64 *out = timestamps.data() + base;
+    if (!readTimestamps(reader, count, [out](std::size_t i, qint64 value) { out[i] = value; })
+        || reader.overrun()) {
+        timestamps.resize(base);
+        return false;
+    }
+    return true;
+}
+
+int runCodecBenchmark(std::size_t sampleCount)
+{
+    // Независимые равномерные значения в диапазонах каналов - худший
+    // случай для XOR-кодирования; период 500 мс с дрожанием таймера
+    const std::size_t kBlockSize = 256;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> jitter(-2, 2);
+    std::vector<Sample> samples(sampleCount);
+    qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    for (std::size_t n = 0; n < sampleCount; ++n) {
+        Sample &sample = samples[n];
+        if (n > 0) {
+            sample = samples[n - 1];
+        }
+        timestamp += 1000 / maxRateHz() + jitter(gen);
+        sample.timestampMs = timestamp;
+        forEachChannel([&](auto index, const auto &channel) {
+            constexpr std::size_t I = decltype(index)::value;
+            using T = ValueType<I>;
+            if (n % (maxRateHz() / channel.rateHz) != 0) {
+                return;
+            }
+            if constexpr (std::is_integral_v<T>) {
+                sample.template get<I>() = std::uniform_int_distribution<T>(channel.simMin, channel.simMax)(gen);
+            } else {
+                sample.template get<I>() = std::uniform_real_distribution<T>(channel.simMin, channel.simMax)(gen);
+            }
+        });
+    }
+
+    // Текстовый журнал - как строки telemetryLog
+    QElapsedTimer timer;
+    timer.start();
+    qint64 textBytes = 0;
+    for (const Sample &sample : samples) {
+        const QString line = QString("[%1] %2")
+                             .arg(QDateTime::fromMSecsSinceEpoch(sample.timestampMs).toString("dd.MM.yyyy hh:mm:ss"))
+                             .arg(formatValues(sample));
+        textBytes += line.toUtf8().size() + 1;
+    }
+    const double textSeconds = timer.nsecsElapsed() / 1e9;
+
+    timer.restart();
+    std::vector<QByteArray> blocks;
+    qint64 codecBytes = 0;
+    for (std::size_t first = 0; first < sampleCount; first += kBlockSize) {
+        const std::size_t count = std::min(kBlockSize, sampleCount - first);
+        blocks.push_back(encodeBlock(samples.data() + first, count));
+        codecBytes += blocks.back().size();
+    }
+    const double encodeSeconds = timer.nsecsElapsed() / 1e9;
+
+    timer.restart();
+    std::vector<Sample> decoded;
+    decoded.reserve(sampleCount);
+    bool ok = true;
+    for (const QByteArray &block : blocks) {
+        ok = decodeBlock(block, decoded) && ok;
+    }
+    const double decodeSeconds = timer.nsecsElapsed() / 1e9;
+
+    // Проверка: метки и целые - точно, вещественные - до точности канала
+    ok = ok && decoded.size() == samples.size();
+    for (std::size_t n = 0; ok && n < samples.size(); ++n) {
+        ok = decoded[n].timestampMs == samples[n].timestampMs;
+        forEachChannel([&](auto index, const auto &channel) {
+            constexpr std::size_t I = decltype(index)::value;
+            const double error = std::abs(static_cast<double>(decoded[n].template get<I>())
+                                          - static_cast<double>(samples[n].template get<I>()));
+            ok = ok && error <= 0.5 / precisionScale(channel.precision) + 1e-12;
+        });
+    }
+
+    const double count = static_cast<double>(sampleCount);
+    std::printf("Samples:      %zu (blocks of %zu)\n", sampleCount, kBlockSize);
+    std::printf("Text log:     %lld bytes, %.1f B/sample, format %.2f Msamples/s\n",
+                static_cast<long long>(textBytes), textBytes / count, count / textSeconds / 1e6);
+    std::printf("Codec:        %lld bytes, %.2f B/sample, ratio %.1fx\n",
+                static_cast<long long>(codecBytes), codecBytes / count,
+                static_cast<double>(textBytes) / codecBytes);
+    std::printf("Encode:       %.2f Msamples/s, %.1f MB/s out\n",
+                count / encodeSeconds / 1e6, codecBytes / encodeSeconds / 1e6);
+    std::printf("Decode:       %.2f Msamples/s, %.1f MB/s in\n",
+                count / decodeSeconds / 1e6, codecBytes / decodeSeconds / 1e6);
+    std::printf("Round trip:   %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
+
+} // namespace telemetry
@@ -0,0 +1,36 @@
+#ifndef TELEMETRYCODEC_H
+#define TELEMETRYCODEC_H
+
+#include <QByteArray>
+#include <cstddef>
+#include <vector>
+
+#include "telemetryschema.h"
+
+// Столбцовое сжатие телеметрии для записи на диск и пакетов по сети.
+// Блок самодостаточен: число отсчётов, затем столбцы в порядке схемы:
+//   метки времени - delta-of-delta с переменной длиной (как в Gorilla);
+//   вещественные  - XOR с предыдущим значением (Gorilla), значение
+//                   предварительно приводится к точности канала (precision);
+//   целые         - бит «не изменилось» либо zigzag-varint разницы.
+namespace telemetry {
+
+QByteArray encodeBlock(const Sample *samples, std::size_t count);
+bool decodeBlock(const QByteArray &block, std::vector<Sample> &samples);
+
+inline QByteArray encodeBlock(const std::vector<Sample> &samples)
+{
+    return encodeBlock(samples.data(), samples.size());
+}
+
+// Отдельный столбец меток времени (например, кадров видео)
+QByteArray encodeTimestamps(const qint64 *timestamps, std::size_t count);
+bool decodeTimestamps(const QByteArray &block, std::vector<qint64> &timestamps);
+
+// Замер скорости кодирования/декодирования и степени сжатия
+// относительно текстового журнала; запускается ключом --bench-codec
+int runCodecBenchmark(std::size_t sampleCount);
+
+} // namespace telemetry
+
+#endif // TELEMETRYCODEC_H
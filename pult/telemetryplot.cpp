@@ -0,0 +1,112 @@
+#include "telemetryplot.h"
+#include <QPainter>
+#include <QLineF>
+#include <QVector>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const QColor kBackground(26, 26, 26);
+const QColor kTrace(100, 255, 100);
+const QColor kText(160, 160, 160);
+
+} // namespace
+
+TelemetryPlot::TelemetryPlot(const QString &title, int precision,
+                             TimestampsQuery timestampsQuery, RangeQuery rangeQuery,
+                             QWidget *parent)
+    : QWidget(parent),
+      title(title),
+      precision(precision),
+      timestampsQuery(std::move(timestampsQuery)),
+      rangeQuery(std::move(rangeQuery)),
+      windowEnd(0),
+      windowSpan(60000)
+{
+    setMinimumHeight(40);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TelemetryPlot::setWindow(qint64 endMs, qint64 spanMs)
+{
+    windowEnd = endMs;
+    windowSpan = std::max<qint64>(1, spanMs);
+}
+
+void TelemetryPlot::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), kBackground);
+    painter.setPen(kText);
+    painter.setFont(QFont("Arial", 8));
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignLeft | Qt::AlignTop, title);
+
+    const QRect area = rect().adjusted(4, 14, -4, -2);
+    const std::vector<qint64> &times = timestampsQuery();
+    if (times.empty() || area.width() <= 0 || area.height() <= 0) {
+        return;
+    }
+
+    // Столбцы пикселей -> диапазоны отсчётов -> min/max из пирамиды
+    const int width = area.width();
+    columns.resize(width);
+    columnFilled.assign(width, 0);
+
+    const qint64 windowStart = windowEnd - windowSpan;
+    std::size_t first = std::lower_bound(times.cbegin(), times.cend(), windowStart) - times.cbegin();
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+    for (int x = 0; x < width && first < times.size(); ++x) {
+        const qint64 columnEnd = windowStart + windowSpan * (x + 1) / width;
+        const std::size_t last = std::lower_bound(times.cbegin() + first, times.cend(), columnEnd)
+                                 - times.cbegin();
+        if (last > first) {
+            columns[x] = rangeQuery(first, last);
+            columnFilled[x] = 1;
+            low = std::min(low, columns[x].first);
+            high = std::max(high, columns[x].second);
+        }
+        first = last;
+    }
+    if (low > high) {
+        return;
+    }
+    if (high - low < 1e-9) {
+        low -= 0.5;
+        high += 0.5;
+    }
+
+    const double scale = area.height() / (high - low);
+    auto mapY = [&](double value) {
+        return area.bottom() - (value - low) * scale;
+    };
+
+    // Вертикальный отрезок min..max на столбец и связка соседних столбцов
+    QVector<QLineF> lines;
+    lines.reserve(width * 2);
+    bool havePrevious = false;
+    QPointF previous;
+    for (int x = 0; x < width; ++x) {
+        if (!columnFilled[x]) {
+            continue;
+        }
+        const double px = area.left() + x + 0.5;
+        const double top = mapY(columns[x].second);
+        const double bottom = mapY(columns[x].first);
+        lines.append(QLineF(px, top, px, bottom));
+        const QPointF middle(px, (top + bottom) / 2);
+        if (havePrevious) {
+            lines.append(QLineF(previous, middle));
+        }
+        previous = middle;
+        havePrevious = true;
+    }
+
+    painter.setPen(kTrace);
+    painter.drawLines(lines);
+
+    painter.setPen(kText);
+    painter.drawText(area, Qt::AlignRight | Qt::AlignTop, QString::number(high, 'f', precision));
+    painter.drawText(area, Qt::AlignRight | Qt::AlignBottom, QString::number(low, 'f', precision));
+}
@@ -0,0 +1,47 @@
+#ifndef TELEMETRYPLOT_H
+#define TELEMETRYPLOT_H
+
+#include <QWidget>
+#include <QString>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Прокручиваемый график одного канала телеметрии. На каждый столбец
+// пикселей запрашивается min/max отсчётов, попавших в его интервал
+// времени (через пирамиду истории), поэтому стоимость отрисовки зависит
+// от ширины виджета, а не от числа накопленных отсчётов.
+class TelemetryPlot : public QWidget
+{
+    Q_OBJECT
+
+public:
+    // Метки времени отсчётов (по возрастанию)
+    using TimestampsQuery = std::function<const std::vector<qint64> &()>;
+    // min/max значений канала на отсчётах [first, last)
+    using RangeQuery = std::function<std::pair<double, double>(std::size_t, std::size_t)>;
+
+    TelemetryPlot(const QString &title, int precision,
+                  TimestampsQuery timestampsQuery, RangeQuery rangeQuery,
+                  QWidget *parent = nullptr);
+
+    // Показываемое окно времени: (endMs - spanMs, endMs]
+    void setWindow(qint64 endMs, qint64 spanMs);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QString title;
+    int precision;
+    TimestampsQuery timestampsQuery;
+    RangeQuery rangeQuery;
+    qint64 windowEnd;
+    qint64 windowSpan;
+
+    // Переиспользуемые между кадрами буферы столбцов
+    std::vector<std::pair<double, double>> columns;
+    std::vector<char> columnFilled;
+};
+
+#endif // TELEMETRYPLOT_H
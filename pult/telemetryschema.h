@@ -0,0 +1,263 @@
+#ifndef TELEMETRYSCHEMA_H
+#define TELEMETRYSCHEMA_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lodpyramid.h"
+
+// Схема каналов телеметрии. Каждый датчик описывается здесь один раз:
+// тип значения, единицы, частота и параметры отображения. Панель,
+// журнал, файлы записи и история строятся по этому описанию, поэтому
+// новый датчик добавляется одной строкой в kChannels.
+namespace telemetry {
+
+template<typename T>
+struct Channel
+{
+    using value_type = T;
+
+    const char *key;        // имя в файлах
+    const char *label;      // подпись на панели
+    const char *units;      // единицы на панели
+    const char *logName;    // имя в журнале
+    const char *logUnits;   // единицы в журнале
+    int rateHz;             // частота обновления датчика
+    int digits;             // разрядов на индикаторе
+    int precision;          // знаков после запятой
+    T simMin;               // диапазон имитации
+    T simMax;
+};
+
+inline constexpr auto kChannels = std::make_tuple(
+    Channel<double>{"distance", "Расстояние", "см", "Dist", "cm", 2, 6, 1, 5.0, 200.0},
+    Channel<double>{"temperature", "Температура", "°C", "Temp", "°C", 2, 5, 1, 10.0, 40.0},
+    Channel<int>{"humidity", "Влажность", "%", "Hum", "%", 2, 3, 0, 30, 80},
+    Channel<int>{"battery", "Заряд батареи", "%", "Batt", "%", 1, 3, 0, 60, 100},
+    Channel<double>{"gps", "Смещение GPS", "°", "GPS", "°", 1, 9, 6, 0.0, 0.001}
+);
+
+// Номера каналов в kChannels
+enum ChannelId : std::size_t { Distance, Temperature, Humidity, Battery, Gps };
+
+constexpr std::size_t kChannelCount = std::tuple_size_v<std::decay_t<decltype(kChannels)>>;
+static_assert(Gps + 1 == kChannelCount, "ChannelId не совпадает с kChannels");
+
+// Частота самого быстрого канала - частота опроса датчиков
+constexpr int maxRateHz()
+{
+    return std::apply([](const auto &...channel) {
+        int rate = 1;
+        ((rate = channel.rateHz > rate ? channel.rateHz : rate), ...);
+        return rate;
+    }, kChannels);
+}
+
+template<std::size_t I>
+using ChannelType = std::decay_t<std::tuple_element_t<I, std::decay_t<decltype(kChannels)>>>;
+
+template<std::size_t I>
+using ValueType = typename ChannelType<I>::value_type;
+
+namespace detail {
+
+template<typename... T>
+std::tuple<T...> valuesOf(const std::tuple<Channel<T>...> &);
+
+template<typename... T>
+std::tuple<std::vector<T>...> columnsOf(const std::tuple<Channel<T>...> &);
+
+template<typename... T>
+std::tuple<MinMaxPyramid<T>...> pyramidsOf(const std::tuple<Channel<T>...> &);
+
+template<typename F, std::size_t... I>
+void forEachChannel(F &&f, std::index_sequence<I...>)
+{
+    (f(std::integral_constant<std::size_t, I>{}, std::get<I>(kChannels)), ...);
+}
+
+} // namespace detail
+
+// Вызывает f(index, channel) для каждого канала; index - integral_constant,
+// поэтому внутри f доступен constexpr номер канала: decltype(index)::value
+template<typename F>
+void forEachChannel(F &&f)
+{
+    detail::forEachChannel(f, std::make_index_sequence<kChannelCount>{});
+}
+
+using Values = decltype(detail::valuesOf(kChannels));
+using Columns = decltype(detail::columnsOf(kChannels));
+using Pyramids = decltype(detail::pyramidsOf(kChannels));
+
+// Один отсчёт всех каналов
+struct Sample
+{
+    qint64 timestampMs = 0;
+    Values values{};
+
+    template<std::size_t I>
+    ValueType<I> &get() { return std::get<I>(values); }
+
+    template<std::size_t I>
+    const ValueType<I> &get() const { return std::get<I>(values); }
+};
+
+template<typename T>
+QString formatValue(T value, const Channel<T> &channel)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        return QString::number(value, 'f', channel.precision);
+    } else {
+        return QString::number(value);
+    }
+}
+
+// "Dist: 12.3cm, Temp: 25.0°C, ..."
+inline QString formatValues(const Sample &sample)
+{
+    QStringList parts;
+    forEachChannel([&](auto index, const auto &channel) {
+        parts << QString("%1: %2%3")
+                 .arg(channel.logName)
+                 .arg(formatValue(sample.get<decltype(index)::value>(), channel))
+                 .arg(channel.logUnits);
+    });
+    return parts.join(", ");
+}
+
+// Значения через пробел в порядке kChannels (строки T в файле .tlm)
+inline QString formatFields(const Sample &sample)
+{
+    QStringList parts;
+    forEachChannel([&](auto index, const auto &channel) {
+        parts << formatValue(sample.get<decltype(index)::value>(), channel);
+    });
+    return parts.join(' ');
+}
+
+// Разбирает значения начиная с fields[first]. Каналов в записи может быть
+// меньше (старые записи) - недостающие остаются по умолчанию.
+inline bool parseFields(const QList<QByteArray> &fields, int first, Sample &sample)
+{
+    bool ok = true;
+    forEachChannel([&](auto index, const auto &) {
+        constexpr std::size_t I = decltype(index)::value;
+        const int position = first + static_cast<int>(I);
+        if (!ok || position >= fields.size()) {
+            return;
+        }
+        if constexpr (std::is_floating_point_v<ValueType<I>>) {
+            sample.get<I>() = fields[position].toDouble(&ok);
+        } else {
+            sample.get<I>() = fields[position].toInt(&ok);
+        }
+    });
+    return ok;
+}
+
+inline QDataStream &operator<<(QDataStream &out, const Sample &sample)
+{
+    out << sample.timestampMs;
+    std::apply([&out](const auto &...value) { ((out << value), ...); }, sample.values);
+    return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, Sample &sample)
+{
+    in >> sample.timestampMs;
+    std::apply([&in](auto &...value) { ((in >> value), ...); }, sample.values);
+    return in;
+}
+
+// История отсчётов: отдельный столбец (вектор) на каждый канал
+// и пирамида min/max над ним для прореживания при отрисовке
+class History
+{
+public:
+    void append(const Sample &sample)
+    {
+        times.push_back(sample.timestampMs);
+        appendValues(sample, std::make_index_sequence<kChannelCount>{});
+    }
+
+    void clear()
+    {
+        times.clear();
+        std::apply([](auto &...column) { (column.clear(), ...); }, columns);
+        std::apply([](auto &...pyramid) { (pyramid.clear(), ...); }, pyramids);
+    }
+
+    // Отбрасывает отсчёты старше timestampMs. Начало столбцов сдвигается
+    // пачками не меньше четверти истории, так что в среднем это O(1) на
+    // добавленный отсчёт; лишнего хранится не больше трети
+    void dropBefore(qint64 timestampMs)
+    {
+        const std::size_t count =
+            std::lower_bound(times.cbegin(), times.cend(), timestampMs) - times.cbegin();
+        if (count == 0 || count < times.size() / 4) {
+            return;
+        }
+        times.erase(times.begin(), times.begin() + count);
+        std::apply([count](auto &...column) { (column.erase(column.begin(), column.begin() + count), ...); },
+                   columns);
+        std::apply([count](auto &...pyramid) { (pyramid.dropFront(count), ...); }, pyramids);
+    }
+
+    void reserve(std::size_t count)
+    {
+        times.reserve(count);
+        std::apply([count](auto &...column) { (column.reserve(count), ...); }, columns);
+    }
+
+    std::size_t size() const { return times.size(); }
+    bool empty() const { return times.empty(); }
+
+    const std::vector<qint64> &timestamps() const { return times; }
+
+    template<std::size_t I>
+    const std::vector<ValueType<I>> &column() const { return std::get<I>(columns); }
+
+    // min/max канала I на отсчётах [first, last), first < last
+    template<std::size_t I>
+    std::pair<ValueType<I>, ValueType<I>> range(std::size_t first, std::size_t last) const
+    {
+        return std::get<I>(pyramids).range(std::get<I>(columns), first, last);
+    }
+
+    Sample at(std::size_t row) const
+    {
+        Sample sample;
+        sample.timestampMs = times[row];
+        forEachChannel([&](auto index, const auto &) {
+            constexpr std::size_t I = decltype(index)::value;
+            sample.get<I>() = std::get<I>(columns)[row];
+        });
+        return sample;
+    }
+
+private:
+    template<std::size_t... I>
+    void appendValues(const Sample &sample, std::index_sequence<I...>)
+    {
+        (std::get<I>(columns).push_back(sample.get<I>()), ...);
+        (std::get<I>(pyramids).append(sample.get<I>()), ...);
+    }
+
+    std::vector<qint64> times;
+    Columns columns;
+    Pyramids pyramids;
+};
+
+} // namespace telemetry
+
+#endif // TELEMETRYSCHEMA_H
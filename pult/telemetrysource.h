@@ -0,0 +1,24 @@
+#ifndef TELEMETRYSOURCE_H
+#define TELEMETRYSOURCE_H
+
+#include <QString>
+#include <vector>
+
+#include "telemetryschema.h"
+
+// Источник телеметрии для пульта (робот или имитатор). Отсчёты
+// накапливаются источником, пульт забирает их пачкой по своему таймеру,
+// поэтому частота датчиков не привязана к частоте обновления экрана.
+class TelemetrySource
+{
+public:
+    virtual ~TelemetrySource() = default;
+
+    virtual QString name() const = 0;
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    // Дописывает в out отсчёты, появившиеся с прошлого вызова
+    virtual void poll(std::vector<telemetry::Sample> &out) = 0;
+};
+
+#endif // TELEMETRYSOURCE_H
@@ -0,0 +1,256 @@
+#include "uiwatchdog.h"
+#include <QMetaObject>
+#include <QStringList>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Сколько последних зависаний хранить для панели и журнала
+const int kRecentStalls = 16;
+// Как часто сторож проверяет, не затянулось ли ожидание ответа
+const int kPollMs = 5;
+
+QString formatUs(qint64 us)
+{
+    return us < 10000 ? QString("%1 мс").arg(us / 1000.0, 0, 'f', 1)
+                      : QString("%1 мс").arg(us / 1000);
+}
+
+} // namespace
+
+std::atomic<const char *> UiWatchdog::currentSlot{nullptr};
+
+void UiWatchdog::Histogram::add(qint64 us)
+{
+    us = std::max<qint64>(us, 0);
+    int index = 0;
+    while (index + 1 < kBuckets && us >= bucketLimitUs(index)) {
+        ++index;
+    }
+    ++buckets[index];
+    ++total;
+    sum += us;
+    maximum = std::max(maximum, us);
+}
+
+qint64 UiWatchdog::Histogram::meanUs() const
+{
+    return total ? sum / static_cast<qint64>(total) : 0;
+}
+
+qint64 UiWatchdog::Histogram::percentileUs(double p) const
+{
+    if (total == 0) {
+        return 0;
+    }
+    const quint64 rank = static_cast<quint64>(p * (total - 1)) + 1;
+    quint64 seen = 0;
+    for (int index = 0; index < kBuckets; ++index) {
+        seen += buckets[index];
+        if (seen >= rank) {
+            return std::min(bucketLimitUs(index), maximum);
+        }
+    }
+    return maximum;
+}
+
+qint64 UiWatchdog::Histogram::bucketLimitUs(int bucket)
+{
+    return qint64(1) << bucket;
+}
+
+UiWatchdog::Scope::Scope(const char *name)
+    : previous(currentSlot.exchange(name))
+{
+}
+
+UiWatchdog::Scope::~Scope()
+{
+    currentSlot.store(previous);
+}
+
+UiWatchdog::UiWatchdog(QObject *parent)
+    : QObject(parent),
+      heartbeatMs(0),
+      stallThresholdMs(0),
+      stopRequested(false),
+      acknowledgedBeat(0),
+      keyPending(false),
+      keyQueuedUs(0),
+      eventClockOffsetMs(0),
+      haveEventClockOffset(false)
+{
+    clock.start();
+}
+
+UiWatchdog::~UiWatchdog()
+{
+    stop();
+}
+
+void UiWatchdog::start(int heartbeat, int stallThreshold)
+{
+    if (worker.joinable()) {
+        return;
+    }
+    heartbeatMs = heartbeat;
+    stallThresholdMs = stallThreshold;
+    stopRequested = false;
+    worker = std::thread(&UiWatchdog::run, this);
+}
+
+void UiWatchdog::stop()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeup.notify_all();
+    worker.join();
+}
+
+void UiWatchdog::run()
+{
+    quint64 beat = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopRequested) {
+        ++beat;
+        const qint64 sentUs = clock.nsecsElapsed() / 1000;
+        // Вызов с контекстом this отбрасывается, если сторож уже удалён
+        QMetaObject::invokeMethod(this, [this, beat]() { acknowledge(beat); }, Qt::QueuedConnection);
+
+        // Ждём ответа; слот, выполнявшийся при превышении порога, и есть
+        // виновник зависания
+        const char *slot = nullptr;
+        bool overThreshold = false;
+        while (!stopRequested && acknowledgedBeat < beat) {
+            wakeup.wait_for(lock, std::chrono::milliseconds(kPollMs));
+            if (!overThreshold && clock.nsecsElapsed() / 1000 - sentUs >= stallThresholdMs * 1000LL) {
+                overThreshold = true;
+                slot = currentSlot.load();
+            }
+        }
+        if (stopRequested) {
+            break;
+        }
+
+        const qint64 latencyUs = clock.nsecsElapsed() / 1000 - sentUs;
+        data.loopLatency.add(latencyUs);
+        if (overThreshold) {
+            const Stall stall{latencyUs / 1000, slot ? QString::fromUtf8(slot) : QString("вне отмеченных слотов")};
+            ++data.stalls;
+            data.recentStalls.append(stall);
+            if (data.recentStalls.size() > kRecentStalls) {
+                data.recentStalls.removeFirst();
+            }
+            QMetaObject::invokeMethod(this, [this, stall]() { emit stalled(stall.durationMs, stall.slot); },
+                                      Qt::QueuedConnection);
+        }
+
+        // Следующий пульс - через heartbeatMs после отправки этого
+        const qint64 waitUs = heartbeatMs * 1000LL - latencyUs;
+        if (waitUs > 0) {
+            wakeup.wait_for(lock, std::chrono::microseconds(waitUs), [this]() { return stopRequested; });
+        }
+    }
+}
+
+void UiWatchdog::acknowledge(quint64 beat)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        acknowledgedBeat = std::max(acknowledgedBeat, beat);
+    }
+    wakeup.notify_all();
+}
+
+void UiWatchdog::keyPressed(quint64 eventTimestampMs)
+{
+    keyClock.start();
+    keyPending = true;
+    keyQueuedUs = 0;
+    if (eventTimestampMs == 0) {
+        // Синтетическое событие без метки - считаем только обработку
+        return;
+    }
+
+    // Метка события идёт по часам оконной системы (у X11 - по часам
+    // сервера), с нашими они расходятся на постоянную величину. Её
+    // оцениваем по самой быстрой доставке: сколько событие сверх неё
+    // шло до нас, столько оно и ждало в очереди за занятым GUI-потоком
+    const qint64 offsetMs = clock.elapsed() - static_cast<qint64>(eventTimestampMs);
+    if (!haveEventClockOffset || offsetMs < eventClockOffsetMs) {
+        eventClockOffsetMs = offsetMs;
+        haveEventClockOffset = true;
+    }
+    keyQueuedUs = (offsetMs - eventClockOffsetMs) * 1000;
+}
+
+void UiWatchdog::commandDispatched()
+{
+    if (!keyPending) {
+        return;
+    }
+    keyPending = false;
+    const qint64 latencyUs = keyQueuedUs + keyClock.nsecsElapsed() / 1000;
+    std::lock_guard<std::mutex> lock(mutex);
+    data.keyLatency.add(latencyUs);
+}
+
+void UiWatchdog::keyHandled()
+{
+    keyPending = false;
+}
+
+UiWatchdog::Stats UiWatchdog::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return data;
+}
+
+QString UiWatchdog::summary() const
+{
+    const Stats current = stats();
+    QString text = QString("Отклик UI: p99 %1, макс %2, зависаний %3")
+                       .arg(formatUs(current.loopLatency.percentileUs(0.99)))
+                       .arg(formatUs(current.loopLatency.maxUs()))
+                       .arg(current.stalls);
+    if (current.keyLatency.count() > 0) {
+        text += QString(" | клавиша→команда: %1 (макс %2)")
+                    .arg(formatUs(current.keyLatency.meanUs()))
+                    .arg(formatUs(current.keyLatency.maxUs()));
+    }
+    return text;
+}
+
+QString UiWatchdog::report() const
+{
+    const Stats current = stats();
+    QStringList lines;
+    auto appendHistogram = [&lines](const QString &title, const Histogram &histogram) {
+        lines << QString("%1: %2 замеров, среднее %3, p50 %4, p99 %5, макс %6")
+                     .arg(title)
+                     .arg(histogram.count())
+                     .arg(formatUs(histogram.meanUs()))
+                     .arg(formatUs(histogram.percentileUs(0.5)))
+                     .arg(formatUs(histogram.percentileUs(0.99)))
+                     .arg(formatUs(histogram.maxUs()));
+        for (int index = 0; index < Histogram::kBuckets; ++index) {
+            if (histogram.bucket(index) > 0) {
+                lines << QString("  < %1: %2").arg(formatUs(Histogram::bucketLimitUs(index)))
+                                              .arg(histogram.bucket(index));
+            }
+        }
+    };
+    appendHistogram("Задержка цикла событий", current.loopLatency);
+    appendHistogram("Клавиша→команда", current.keyLatency);
+    lines << QString("Зависаний дольше %1 мс: %2").arg(stallThresholdMs).arg(current.stalls);
+    for (const Stall &stall : current.recentStalls) {
+        lines << QString("  %1 мс: %2").arg(stall.durationMs).arg(stall.slot);
+    }
+    return lines.join('\n');
+}
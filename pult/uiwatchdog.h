@@ -0,0 +1,128 @@
+#ifndef UIWATCHDOG_H
+#define UIWATCHDOG_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Сторож цикла событий GUI. Отдельный поток каждые heartbeatMs ставит
+// в очередь GUI-потока пустой вызов и меряет, через сколько он выполнен;
+// задержки копятся в гистограмме. Если ответа нет дольше stallThresholdMs,
+// сторож запоминает слот, который в этот момент выполняется (его
+// отмечает UiWatchdog::Scope), и сообщает о зависании сигналом stalled().
+// Кроме того, меряется задержка от нажатия клавиши до отправки команды,
+// включая время, которое событие клавиши простояло в очереди.
+class UiWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Гистограмма задержек по степеням двойки в микросекундах:
+    // корзина k - задержки [2^(k-1), 2^k) мкс, последняя - всё, что больше
+    class Histogram
+    {
+    public:
+        static constexpr int kBuckets = 25;  // до ~16 с
+
+        void add(qint64 us);
+        quint64 count() const { return total; }
+        qint64 maxUs() const { return maximum; }
+        qint64 meanUs() const;
+        // Верхняя граница корзины, в которую попал перцентиль p (0..1)
+        qint64 percentileUs(double p) const;
+        static qint64 bucketLimitUs(int bucket);
+        quint64 bucket(int index) const { return buckets[index]; }
+
+    private:
+        std::array<quint64, kBuckets> buckets{};
+        quint64 total = 0;
+        qint64 sum = 0;
+        qint64 maximum = 0;
+    };
+
+    struct Stall
+    {
+        qint64 durationMs;
+        QString slot;
+    };
+
+    struct Stats
+    {
+        Histogram loopLatency;
+        Histogram keyLatency;
+        quint64 stalls = 0;
+        QVector<Stall> recentStalls;
+    };
+
+    // Отмечает выполняемый в GUI-потоке слот на время своей жизни:
+    //   UiWatchdog::Scope scope(Q_FUNC_INFO);
+    // name должно жить всё время работы (строковый литерал)
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char *previous;
+    };
+
+    explicit UiWatchdog(QObject *parent = nullptr);
+    ~UiWatchdog();
+
+    void start(int heartbeatMs, int stallThresholdMs);
+    void stop();
+
+    // Вызываются из GUI-потока: клавиша получена (eventTimestampMs -
+    // QKeyEvent::timestamp()) / команда отправлена / обработка клавиши
+    // закончена. Неотправленная команда замера не даёт
+    void keyPressed(quint64 eventTimestampMs);
+    void commandDispatched();
+    void keyHandled();
+
+    Stats stats() const;
+    // Краткая строка для панели статуса
+    QString summary() const;
+    // Гистограммы целиком для журнала
+    QString report() const;
+
+signals:
+    void stalled(qint64 durationMs, const QString &slot);
+
+private:
+    void run();
+    void acknowledge(quint64 beat);
+
+    static std::atomic<const char *> currentSlot;
+
+    int heartbeatMs;
+    int stallThresholdMs;
+    QElapsedTimer clock;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopRequested;
+    quint64 acknowledgedBeat;
+    Stats data;
+
+    // Только GUI-поток
+    QElapsedTimer keyClock;
+    bool keyPending;
+    // Сколько событие клавиши ждало в очереди до keyPressed()
+    qint64 keyQueuedUs;
+    // Наименьшая разница наших часов и часов оконной системы
+    qint64 eventClockOffsetMs;
+    bool haveEventClockOffset;
+};
+
+#endif // UIWATCHDOG_H
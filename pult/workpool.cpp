@@ -0,0 +1,163 @@
+#include "workpool.h"
+#include <QDebug>
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+// Номер потока пула, в котором выполняется код; -1 - чужой поток
+thread_local int currentWorker = -1;
+thread_local const WorkPool *currentPool = nullptr;
+
+} // namespace
+
+WorkPool::WorkPool(int threadCount)
+    : nextWorker(0),
+      totalBusyNs(0),
+      queued(0),
+      stopping(false)
+{
+    if (threadCount <= 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    clock.start();
+    for (int i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // Потоки запускаются, когда все очереди уже созданы: соседи
+    // заглядывают в них с первой итерации
+    for (int i = 0; i < threadCount; ++i) {
+        workers[i]->thread = std::thread(&WorkPool::run, this, i);
+    }
+}
+
+WorkPool::~WorkPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto &worker : workers) {
+        worker->thread.join();
+    }
+}
+
+int WorkPool::threadCount() const
+{
+    return static_cast<int>(workers.size());
+}
+
+void WorkPool::submit(ResourceAccount &account, std::function<void()> task)
+{
+    ++account.pending;
+    const int index = currentPool == this
+                      ? currentWorker
+                      : static_cast<int>(nextWorker++ % workers.size());
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back({std::move(task), &account, clock.nsecsElapsed()});
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    wakeup.notify_one();
+}
+
+void WorkPool::wait(const ResourceAccount &account)
+{
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    drained.wait(lock, [&account]() { return account.pending.load() == 0; });
+}
+
+qint64 WorkPool::busyNs() const
+{
+    return totalBusyNs.load();
+}
+
+qint64 WorkPool::uptimeNs() const
+{
+    return clock.nsecsElapsed();
+}
+
+void WorkPool::run(int index)
+{
+    currentWorker = index;
+    currentPool = this;
+    while (true) {
+        Task task;
+        if (takeLocal(index, task) || steal(index, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeup.wait(lock, [this]() { return stopping || queued > 0; });
+        // Перед остановкой очереди дорабатываются до конца
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkPool::takeLocal(int index, Task &task)
+{
+    Worker &worker = *workers[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            return false;
+        }
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+    }
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    --queued;
+    return true;
+}
+
+bool WorkPool::steal(int index, Task &task)
+{
+    const int count = threadCount();
+    for (int offset = 1; offset < count; ++offset) {
+        Worker &victim = *workers[(index + offset) % count];
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks.empty()) {
+                continue;
+            }
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+        ++task.account->stolen;
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        --queued;
+        return true;
+    }
+    return false;
+}
+
+void WorkPool::execute(Task &task)
+{
+    const qint64 startNs = clock.nsecsElapsed();
+    try {
+        task.run();
+    } catch (const std::exception &error) {
+        qWarning() << "[POOL] task failed:" << error.what();
+    }
+    const qint64 busy = clock.nsecsElapsed() - startNs;
+
+    ResourceAccount &account = *task.account;
+    ++account.tasks;
+    account.busyNs += busy;
+    account.waitNs += startNs - task.queuedNs;
+    totalBusyNs += busy;
+
+    // Задача больше не нужна: её захваченные данные (кадры записи)
+    // освобождаются до того, как wait() сообщит о завершении
+    task.run = nullptr;
+    if (--account.pending == 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        drained.notify_all();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Учёт ресурсов пула для одного владельца задач (сессии робота)
+struct ResourceAccount
+{
+    struct Snapshot
+    {
+        quint64 tasks = 0;
+        quint64 stolen = 0;
+        qint64 busyNs = 0;   // время выполнения задач на потоках пула
+        qint64 waitNs = 0;   // время задач в очереди до запуска
+    };
+
+    Snapshot snapshot() const
+    {
+        return {tasks.load(), stolen.load(), busyNs.load(), waitNs.load()};
+    }
+
+    std::atomic<quint64> tasks{0};
+    std::atomic<quint64> stolen{0};
+    std::atomic<qint64> busyNs{0};
+    std::atomic<qint64> waitNs{0};
+    // Поставлено, но ещё не выполнено
+    std::atomic<int> pending{0};
+};
+
+// Общий пул потоков с перехватом работы (work stealing). У каждого
+// потока своя очередь: свои задачи он берёт с конца (последняя
+// поставленная - ещё в кэше), а когда она пуста - забирает самые
+// старые задачи из начала очередей соседей. Задачи из GUI-потока
+// раскладываются по очередям по кругу, задачи из потока пула - в его
+// собственную очередь.
+class WorkPool
+{
+public:
+    // threadCount <= 0 - по числу ядер
+    explicit WorkPool(int threadCount = 0);
+    ~WorkPool();
+
+    WorkPool(const WorkPool &) = delete;
+    WorkPool &operator=(const WorkPool &) = delete;
+
+    int threadCount() const;
+
+    void submit(ResourceAccount &account, std::function<void()> task);
+    // Ждёт выполнения всех задач account; не вызывать из потока пула
+    void wait(const ResourceAccount &account);
+
+    // Суммарное время работы потоков и время жизни пула - для загрузки
+    qint64 busyNs() const;
+    qint64 uptimeNs() const;
+
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        ResourceAccount *account;
+        qint64 queuedNs;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void run(int index);
+    bool takeLocal(int index, Task &task);
+    bool steal(int index, Task &task);
+    void execute(Task &task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    QElapsedTimer clock;
+    std::atomic<unsigned> nextWorker;
+    std::atomic<qint64> totalBusyNs;
+
+    // Сон свободных потоков и ожидание wait()
+    std::mutex sleepMutex;
+    std::condition_variable wakeup;
+    std::condition_variable drained;
+    int queued;
+    bool stopping;
+};
+
+#endif // WORKPOOL_H